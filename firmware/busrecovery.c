@@ -0,0 +1,188 @@
+/* Name: busrecovery.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Recovers from I2C bus faults and reconfigures the sensor.
+ *
+ * The TWI_Master code just gives up on a NACK or a bus error, leaving
+ * TWI_statusReg.lastTransOK at zero (and the red LED on). That is fine for
+ * a single glitch, but a loose cable can leave the sensor power-cycled
+ * (and thus unconfigured), or leave it in the middle of a byte, holding
+ * SDA low. In the latter case, the TWI module can't even send a START, and
+ * stays busy forever.
+ *
+ * busrecovery_poll() watches for:
+ * - a TWI transfer taking longer than BUSRECOVERY_TIMEOUT;
+ * - BUSRECOVERY_MAX_ERRORS failed readings in a row.
+ *
+ * Then, it disables the TWI module, clocks SCL up to 9 times (until the
+ * slave releases SDA), generates a STOP condition, and initializes the TWI
+ * module again. After that, sensor_startup() probes the sensor and writes
+ * its configuration. If the sensor still does not answer, everything is
+ * tried again later, with an exponential backoff, so that a missing sensor
+ * does not keep the bus (and the CPU) busy.
+ *
+ * While all this happens, sensor.recovering is set, and the readings are
+ * counted as lost samples. The counters can be read through the
+ * diagnostics report (ENABLE_DIAGNOSTICS).
+ */
+
+
+#include <avr/io.h>
+#include <util/delay.h>
+
+#include "avr315/TWI_Master.h"
+#include "busrecovery.h"
+#include "clock.h"
+#include "diagnostics.h"
+#include "sensor.h"
+
+
+#if ENABLE_BUS_RECOVERY
+
+BusRecovery busrecovery;
+
+
+////////////////////////////////////////////////////////////
+// Constants                                             {{{
+
+// A 7-byte reading at 400KHz takes about 0.2ms.
+#define BUSRECOVERY_TIMEOUT     CLOCK_MS(5)
+
+// The sensor is read at about 146Hz, so this is about 20ms.
+#define BUSRECOVERY_MAX_ERRORS  3
+
+// In Timer0 ticks: about 87ms, doubling up to about 1.4s.
+#define BUSRECOVERY_FIRST_BACKOFF  64
+#define BUSRECOVERY_MAX_BACKOFF    1024
+
+// Half period of the bit-banged SCL (about 50KHz, because the internal
+// pull-ups are weak).
+#define BUSRECOVERY_HALF_PERIOD_US  10
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Bus clearing                                          {{{
+
+// The lines are open-drain: a line is driven low by making it an output
+// with value zero, and released by making it an input with pull-up.
+#define LINE_LOW(bit)      do{ BUSRECOVERY_PORT &= ~(1<<(bit)); BUSRECOVERY_DDR |= (1<<(bit)); }while(0)
+#define LINE_RELEASE(bit)  do{ BUSRECOVERY_DDR &= ~(1<<(bit)); BUSRECOVERY_PORT |= (1<<(bit)); }while(0)
+#define LINE_IS_HIGH(bit)  (BUSRECOVERY_PIN & (1<<(bit)))
+
+static void busrecovery_clear_bus() {  // {{{
+	// This function is blocking, for about 0.2ms.
+
+	uchar i;
+
+	// Disabling the TWI module gives the pins back to PORTC/DDRC.
+	TWCR = 0;
+
+	LINE_RELEASE(BUSRECOVERY_SDA);
+	LINE_RELEASE(BUSRECOVERY_SCL);
+	_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+
+	// A slave holding SDA low is in the middle of sending a byte. Clocking
+	// SCL makes it send the remaining bits, and then it sees a NACK.
+	for (i = 0; i < 9 && !LINE_IS_HIGH(BUSRECOVERY_SDA); i++) {
+		LINE_LOW(BUSRECOVERY_SCL);
+		_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+		LINE_RELEASE(BUSRECOVERY_SCL);
+		_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+	}
+
+	// STOP condition: SDA goes high while SCL is high.
+	LINE_LOW(BUSRECOVERY_SCL);
+	LINE_LOW(BUSRECOVERY_SDA);
+	_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+	LINE_RELEASE(BUSRECOVERY_SCL);
+	_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+	LINE_RELEASE(BUSRECOVERY_SDA);
+	_delay_us(BUSRECOVERY_HALF_PERIOD_US);
+
+	TWI_Master_Initialise();
+}  // }}}
+
+#undef LINE_LOW
+#undef LINE_RELEASE
+#undef LINE_IS_HIGH
+
+// }}}
+
+
+void busrecovery_poll() {  // {{{
+	// Must be called at every iteration of the main loop.
+	//
+	// This function is non-blocking (except for busrecovery_clear_bus()).
+
+	BusRecovery *br = &busrecovery;
+	FIX_POINTER(br);
+
+	uchar return_code;
+
+	switch (br->step) {
+		case BUSRECOVERY_OK:
+			if (TWI_Transceiver_Busy()) {
+				if (!br->busy) {
+					br->busy = 1;
+					br->busy_since = clock_timestamp();
+				} else if (clock_timestamp() - br->busy_since > BUSRECOVERY_TIMEOUT) {
+					DIAGNOSTICS_COUNT(twi_timeouts);
+					br->step = BUSRECOVERY_RECOVER;
+				}
+			} else {
+				br->busy = 0;
+			}
+
+			if (sensor.errors_in_a_row >= BUSRECOVERY_MAX_ERRORS) {
+				br->step = BUSRECOVERY_RECOVER;
+			}
+
+			if (br->step == BUSRECOVERY_OK) return;
+		case BUSRECOVERY_RECOVER:
+			sensor.recovering = 1;
+			br->busy = 0;
+
+			busrecovery_clear_bus();
+			DIAGNOSTICS_COUNT(bus_recoveries);
+
+			sensor_restart();
+			br->step = BUSRECOVERY_REINIT;
+		case BUSRECOVERY_REINIT:
+			return_code = sensor_startup();
+			if (return_code == SENSOR_FUNC_STILL_WORKING) return;
+
+			if (return_code == SENSOR_FUNC_DONE) {
+				DIAGNOSTICS_COUNT(sensor_reinits);
+				sensor.errors_in_a_row = 0;
+				sensor.recovering = 0;
+				br->backoff = 0;
+				br->step = BUSRECOVERY_OK;
+				return;
+			}
+
+			// The sensor is still not answering. Waiting before trying
+			// again.
+			if (br->backoff == 0) {
+				br->backoff = BUSRECOVERY_FIRST_BACKOFF;
+			} else if (br->backoff < BUSRECOVERY_MAX_BACKOFF) {
+				br->backoff <<= 1;
+			}
+			br->retry_tick = clock_ticks + br->backoff;
+			br->step = BUSRECOVERY_BACKOFF;
+		case BUSRECOVERY_BACKOFF:
+			if ((int)(clock_ticks - br->retry_tick) < 0) return;
+
+			br->step = BUSRECOVERY_RECOVER;
+	}
+}  // }}}
+
+#endif  // ENABLE_BUS_RECOVERY
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,50 @@
+/* Name: busrecovery.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __busrecovery_h_included__
+#define __busrecovery_h_included__
+
+#include "common.h"
+
+
+#if ENABLE_BUS_RECOVERY
+
+// TWI pins of the ATmega8
+#define BUSRECOVERY_PORT  PORTC
+#define BUSRECOVERY_DDR   DDRC
+#define BUSRECOVERY_PIN   PINC
+#define BUSRECOVERY_SDA   4
+#define BUSRECOVERY_SCL   5
+
+// Steps of busrecovery_poll()
+#define BUSRECOVERY_OK       0
+#define BUSRECOVERY_RECOVER  1
+#define BUSRECOVERY_REINIT   2
+#define BUSRECOVERY_BACKOFF  3
+
+typedef struct BusRecovery {
+	uchar step;
+
+	// Watching for a stuck transfer
+	uchar busy:1;
+	unsigned int busy_since;
+
+	// Waiting before trying again, in Timer0 ticks
+	// backoff is zero until the first failed attempt
+	unsigned int retry_tick;
+	unsigned int backoff;
+} BusRecovery;
+
+extern BusRecovery busrecovery;
+
+
+void busrecovery_poll();
+
+#endif  // ENABLE_BUS_RECOVERY
+
+
+#endif  // __busrecovery_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
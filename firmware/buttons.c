@@ -4,17 +4,153 @@
  * Creation Date: 2011-10-18
  * Tabsize: 4
  * License: GNU GPL v2 or GNU GPL v3
+ *
+ * With ENABLE_PIN_CHANGE_BUTTONS, the buttons are not sampled at every
+ * Timer0 tick. Instead, the pin change interrupt timestamps each edge, and
+ * a change is accepted as soon as it is seen (leading-edge debouncing).
+ * After that, the button is locked until the contacts have been quiet for
+ * BUTTON_QUIET_TIME. This way, a press reaches the next mouse report
+ * without the ~11ms delay of the sampling debouncer. The downside is that
+ * a single spike on an idle input is taken as a press, so the wires should
+ * be short.
+ *
+ * This requires an AVR with pin change interrupts (ATmega88/168/328). The
+ * buttons stay on PC0..PC3, which are PCINT8..PCINT11 on those.
  */
 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 
 #include "buttons.h"
+#include "clock.h"
+#include "diagnostics.h"
 
 
 ButtonState button;
 
 
+#if ENABLE_PIN_CHANGE_BUTTONS
+
+#ifndef PCICR
+#error "ENABLE_PIN_CHANGE_BUTTONS requires an AVR with pin change interrupts (ATmega88/168/328)"
+#endif
+
+// A locked button is released after the contacts have been quiet (no edges
+// on any button) for this long.
+#define BUTTON_QUIET_TIME CLOCK_MS(8)
+
+// Timer0 count and clock_isr_ticks at the latest edge on any button. The
+// interrupt only latches them, update_button_state() builds the timestamp.
+static volatile uchar button_edge_tcnt;
+static volatile uchar button_edge_ticks;
+
+
+void init_button_state() {  // {{{
+	// Must be called before enabling the interrupts.
+	PCMSK1 = ALL_BUTTONS;  // PCINT8..PCINT11 are PC0..PC3
+	PCICR |= (1 << PCIE1);
+}  // }}}
+
+
+// ISR_NOBLOCK re-enables the interrupts as the very first instruction, so
+// that this interrupt never delays the USB one, even while the contacts
+// bounce. For the same reason, it makes no function calls (which would make
+// GCC save all call-clobbered registers), and is short enough that a nested
+// edge only repeats the same few instructions.
+ISR(PCINT1_vect, ISR_NOBLOCK) {  // {{{
+	uchar ticks;
+	uchar tcnt;
+
+	// Same as clock_timestamp(): the Timer0 interrupt may run between
+	// reading both bytes. TOV0 can't be pending, as interrupts are enabled.
+	do {
+		ticks = clock_isr_ticks;
+		tcnt = TCNT0;
+	} while (ticks != clock_isr_ticks);
+
+	// A nested edge must not leave a pair made of two different edges
+	cli();
+	button_edge_tcnt = tcnt;
+	button_edge_ticks = ticks;
+}  // }}}
+
+
+void update_button_state(uchar timer_overflow) {  // {{{
+	// It should be called at every iteration of the main loop.
+
+	uchar raw_state;
+	uchar changes;
+	unsigned int edge_time;
+
+	ButtonState *button_ptr = &button;
+	FIX_POINTER(button_ptr);
+
+	// Same wiring as below: pressed buttons read as zero
+	raw_state = (~PINC) & ALL_BUTTONS;
+
+	cli();
+	edge_time = (button_edge_ticks << 8) | button_edge_tcnt;
+	sei();
+
+	if (button_ptr->locked && clock_timestamp() - edge_time >= BUTTON_QUIET_TIME) {
+		// Not bouncing anymore
+		button_ptr->locked = 0;
+	}
+
+	// The first edge of an unlocked button is accepted right away
+	changes = (raw_state ^ button_ptr->state) & ~button_ptr->locked;
+	button_ptr->locked |= changes;
+	button_ptr->changed = changes;
+	button_ptr->state ^= changes;
+
+	if (changes & button_ptr->state) {
+		// The edge that caused this press is the latest one
+		button_ptr->press_time = edge_time;
+		button_ptr->latency_pending = 1;
+	}
+
+#if !ENABLE_CLICK_REWIND
+	if (timer_overflow && button_ptr->recent_state_change) {
+		button_ptr->recent_state_change--;
+	}
+
+	// If any button has been pressed
+	if (changes & button_ptr->state) {
+		// This value was choosen empirically.
+		// 64 * 1.365ms = 87.36ms = 11.45Hz
+		button_ptr->recent_state_change = 64;
+	}
+#endif
+}  // }}}
+
+
+#if ENABLE_DIAGNOSTICS
+void button_report_sent() {  // {{{
+	// Must be called right after a report carrying the button state has
+	// been given to usbSetInterrupt(). The host takes it at its next poll.
+
+	ButtonState *button_ptr = &button;
+	FIX_POINTER(button_ptr);
+
+	unsigned int latency;
+
+	if (!button_ptr->latency_pending) {
+		return;
+	}
+	button_ptr->latency_pending = 0;
+
+	latency = clock_timestamp() - button_ptr->press_time;
+	diagnostics_report.button_latency_last = latency;
+	if (latency > diagnostics_report.button_latency_max) {
+		diagnostics_report.button_latency_max = latency;
+	}
+}  // }}}
+#endif
+
+#else  // ENABLE_PIN_CHANGE_BUTTONS
+
+
 /*
 void init_button_state() {  // {{{
 	// According to avr-libc FAQ, the compiler automatically initializes
@@ -38,55 +174,60 @@ void update_button_state(uchar timer_overflow) { // {{{
 	// Timer is set to 1.365ms
 	if (timer_overflow) {
 		uchar raw_state;
-		uchar i;
+		uchar delta;
+		uchar toggle;
 
 		// Buttons are on PC0, PC1, PC2, PC3
 		// Buttons are ON when connected to GND, and read as zero
 		// Buttons are OFF when open, internal pull-ups make them read as one
 
 		// The low nibble of PINC maps to the 4 buttons
-		raw_state = (~PINC) & 0x0F;
+		raw_state = (~PINC) & ALL_BUTTONS;
 		// "raw_state" has the button state, with 1 for pressed and 0 for released.
 		// Still needs debouncing...
 
-		// This debouncing solution is inspired by tiltstick-20080207 firmware.
+		// A button changes its state only after 8 consecutive samples
+		// different from the current state. This is the same behavior of the
+		// shift-register debouncing inspired by tiltstick-20080207 firmware,
+		// used in previous versions, but all buttons are handled at once by
+		// a vertical counter, without any loop.
 		//
-		// Poll the buttons into a shift register for de-bouncing.
-		// A button is considered pressed when the register reaches 0xFF.
-		// A button is considered released when the register reaches 0x00.
-		// Any intermediate value does not change the button state.
+		// Each counter holds how many consecutive samples were different
+		// from the filtered state. It is incremented while the sample
+		// differs, and cleared as soon as it matches again. When it would go
+		// from 7 to 8, it overflows back to zero and the state is toggled.
 		//
 		// 8 * 1.365ms = ~11ms without interruption
-		for (i=0; i<4; i++) {
-			button_ptr->debouncing[i] =
-				(button_ptr->debouncing[i]<<1)
-				| ( ((raw_state & (1<<i)))? 1 : 0 );
-
-			if (button_ptr->debouncing[i] == 0) {
-				// Releasing this button
-				filtered_state &= ~(1<<i);
-			} else if (button_ptr->debouncing[i] == 0xFF) {
-				// Pressing this button
-				filtered_state |=  (1<<i);
-			}
-		}
-
+		delta = raw_state ^ filtered_state;
+		toggle = delta & button_ptr->count[0] & button_ptr->count[1] & button_ptr->count[2];
+		button_ptr->count[2] = (button_ptr->count[2] ^ (button_ptr->count[1] & button_ptr->count[0])) & delta;
+		button_ptr->count[1] = (button_ptr->count[1] ^ button_ptr->count[0]) & delta;
+		button_ptr->count[0] = (~button_ptr->count[0]) & delta;
+		filtered_state ^= toggle;
+
+#if !ENABLE_CLICK_REWIND
 		if (button_ptr->recent_state_change) {
 			button_ptr->recent_state_change--;
 		}
+#endif
 	}
 
 	// Storing the final, filtered, updated state
 	button_ptr->changed = button_ptr->state ^ filtered_state;
 	button_ptr->state = filtered_state;
 
+#if !ENABLE_CLICK_REWIND
 	// If any button has been pressed
 	if (button_ptr->changed & filtered_state) {
 		// This value was choosen empirically.
 		// 64 * 1.365ms = 87.36ms = 11.45Hz
 		button_ptr->recent_state_change = 64;
 	}
+#endif
 }  // }}}
 
 
+#endif  // ENABLE_PIN_CHANGE_BUTTONS
+
+
 // vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
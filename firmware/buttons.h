@@ -14,13 +14,27 @@ typedef struct ButtonState {
 	uchar state;
 	uchar changed;
 
+#if !ENABLE_CLICK_REWIND
 	// This is used to "freeze" the pointer movement for a short while, right
 	// after a click, in order to avoid accidentally dragging the clicked
 	// object. This is useful because the sensor captures a lot of noise.
+	// (ENABLE_CLICK_REWIND does it better, see mouseemu.c)
 	uchar recent_state_change;
+#endif
 
 	// "Private" button debouncing state
-	uchar debouncing[4];  // We have 4 buttons/switches
+#if ENABLE_PIN_CHANGE_BUTTONS
+	// Buttons whose changes are ignored until the contacts stop bouncing
+	uchar locked;
+
+	// Press-to-report latency measurement
+	uchar latency_pending;
+	unsigned int press_time;
+#else
+	// 3-bit vertical counter: bit N of count[K] is bit K of the counter for
+	// the button at bit N. Works for up to 8 buttons at the same cost.
+	uchar count[3];
+#endif
 } ButtonState;
 
 extern ButtonState button;
@@ -41,11 +55,21 @@ extern ButtonState button;
 #define ON_KEY_UP(button_mask)   ((button.changed & (button_mask)) && !(button.state & (button_mask)))
 
 
+#if ENABLE_PIN_CHANGE_BUTTONS
+void init_button_state();
+#else
 // Init does nothing
 #define init_button_state() do{ }while(0)
+#endif
 
 void update_button_state(uchar timer_overflow);
 
+#if ENABLE_PIN_CHANGE_BUTTONS && ENABLE_DIAGNOSTICS
+void button_report_sent();
+#else
+#define button_report_sent() do{ }while(0)
+#endif
+
 
 #endif  // __buttons_h_included____
 
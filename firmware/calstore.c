@@ -0,0 +1,234 @@
+/* Name: calstore.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Log-structured calibration store, with multiple profiles.
+ *
+ * Without this, the calibration is a single SensorEepromData at a fixed
+ * EEPROM address, which is trusted blindly at boot, and every change
+ * writes over the same cells.
+ *
+ * Here, the EEPROM is divided into CALSTORE_SLOTS slots, each one holding a
+ * CalibrationRecord: a schema version, the profile number, a sequence
+ * number, the calibration data and a CRC16. Each save writes a new record
+ * into the next free slot, in a circular way, spreading the wear over
+ * all slots. The slots holding the newest record of each profile are
+ * skipped, so if the power goes away in the middle of a write, the torn
+ * record fails the CRC check and the previous one is used instead.
+ *
+ * At boot, calstore_load() reads all slots and keeps the newest valid
+ * record of each profile in RAM. The profile of the newest record overall
+ * becomes the active one. Profiles without any valid record start with the
+ * default values in PROGMEM, except for the first profile, which is
+ * migrated from the old eeprom_sensor block (if it looks valid).
+ *
+ * Switching profiles only copies the RAM cache into sensor.e, and then a
+ * record is written in the background, so that the same profile is active
+ * after the next boot.
+ *
+ * The writing itself is done by int_eeprom.c. Only one record is written at
+ * a time; a save requested meanwhile is done by calstore_poll() later.
+ */
+
+
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+#include "calstore.h"
+#include "int_eeprom.h"
+#include "sensor.h"
+
+
+#if ENABLE_CALIBRATION_STORE
+
+CalibrationStore calstore;
+
+
+// See sensor.c
+#define X_EEMEM __attribute__((section(".eeprom"), used, externally_visible))
+
+CalibrationRecord X_EEMEM calstore_slots[CALSTORE_SLOTS];
+
+
+// Profile names and default values  {{{
+// Feel free to rename the profiles after your desks or monitors.
+static const char calstore_profile_1[] PROGMEM = "Profile 1\n";
+static const char calstore_profile_2[] PROGMEM = "Profile 2\n";
+static const char calstore_profile_3[] PROGMEM = "Profile 3\n";
+
+PGM_P const calstore_profile_names[CALSTORE_PROFILES] PROGMEM = {
+	calstore_profile_1,
+	calstore_profile_2,
+	calstore_profile_3
+};
+
+// Same as eeprom_sensor at sensor.c
+static const SensorEepromData calstore_defaults PROGMEM = {
+	1,  // zero_compensation
+	{21, -108, 138},  // zero
+	{  // corners
+		{123, 219, 44}, // topleft
+		{-40, 245, 68}, // topright
+		{113, 166, 151}, // bottomleft
+		{-44, 190, 160} // bottomright
+	}
+};
+// }}}
+
+
+static unsigned int calstore_crc(const CalibrationRecord *record) {  // {{{
+	const uchar *p = (const uchar*) record;
+	unsigned int crc = 0xFFFF;
+	uchar i;
+
+	for (i = 0; i < sizeof(CalibrationRecord) - sizeof(record->crc); i++) {
+		crc = _crc16_update(crc, p[i]);
+	}
+	return crc;
+}  // }}}
+
+
+void calstore_load() {  // {{{
+	// Replaces the eeprom_read_block() of eeprom_sensor.
+	// Reads all slots, fills the RAM cache and loads the active profile
+	// into sensor.e.
+	//
+	// This function is blocking, but reading the EEPROM is fast. Reading
+	// and checking all slots takes about 3ms, mostly because of the CRC.
+
+	CalibrationStore *cs = &calstore;
+	FIX_POINTER(cs);
+
+	CalibrationRecord *record = &cs->record;
+	unsigned long profile_sequence[CALSTORE_PROFILES];
+	uchar found_any = 0;
+	uchar slot;
+	uchar p;
+
+	for (p = 0; p < CALSTORE_PROFILES; p++) {
+		cs->profile_slot[p] = CALSTORE_NO_SLOT;
+	}
+
+	for (slot = 0; slot < CALSTORE_SLOTS; slot++) {
+		eeprom_read_block(record, &calstore_slots[slot], sizeof(CalibrationRecord));
+
+		if (record->version != CALSTORE_VERSION
+		|| record->profile >= CALSTORE_PROFILES
+		|| record->crc != calstore_crc(record)) {
+			// Empty, torn or from an old firmware
+			continue;
+		}
+
+		p = record->profile;
+		if (cs->profile_slot[p] == CALSTORE_NO_SLOT || record->sequence > profile_sequence[p]) {
+			cs->profiles[p] = record->data;
+			cs->profile_slot[p] = slot;
+			profile_sequence[p] = record->sequence;
+		}
+
+		if (!found_any || record->sequence > cs->sequence) {
+			found_any = 1;
+			cs->sequence = record->sequence;
+			cs->last_slot = slot;
+			cs->active = p;
+		}
+	}
+
+	if (!found_any) {
+		cs->last_slot = CALSTORE_SLOTS - 1;
+	}
+
+	for (p = 0; p < CALSTORE_PROFILES; p++) {
+		if (cs->profile_slot[p] != CALSTORE_NO_SLOT) continue;
+
+		if (p == 0) {
+			// Migrating from the old fixed block
+			eeprom_read_block(&cs->profiles[0], &eeprom_sensor, sizeof(SensorEepromData));
+			if (cs->profiles[0].zero_compensation <= 1) continue;
+		}
+		memcpy_P(&cs->profiles[p], &calstore_defaults, sizeof(SensorEepromData));
+	}
+
+	sensor.e = cs->profiles[cs->active];
+}  // }}}
+
+
+void calstore_poll() {  // {{{
+	// Must be called at every iteration of the main loop.
+	// Writes the pending record, if any, as soon as the previous one has
+	// been written.
+	//
+	// This function is non-blocking.
+
+	CalibrationStore *cs = &calstore;
+	FIX_POINTER(cs);
+
+	CalibrationRecord *record = &cs->record;
+	uchar slot;
+	uchar p;
+
+	if (!cs->dirty || int_eeprom_busy()) return;
+	cs->dirty = 0;
+
+	// Finding the next free slot. There are always free slots, as long as
+	// CALSTORE_SLOTS > CALSTORE_PROFILES.
+	slot = cs->last_slot;
+	p = 0;
+	while (p < CALSTORE_PROFILES) {
+		slot++;
+		if (slot == CALSTORE_SLOTS) slot = 0;
+		for (p = 0; p < CALSTORE_PROFILES; p++) {
+			if (cs->profile_slot[p] == slot) break;
+		}
+	}
+
+	cs->sequence++;
+	record->version = CALSTORE_VERSION;
+	record->profile = cs->active;
+	record->sequence = cs->sequence;
+	record->data = cs->profiles[cs->active];
+	record->crc = calstore_crc(record);
+
+	int_eeprom_write_block(record, &calstore_slots[slot], sizeof(CalibrationRecord));
+
+	// From now on, the old slot of this profile can be reused. If the
+	// power goes away before this record is completely written, it will be
+	// used anyway, as the new one will fail the CRC check.
+	cs->profile_slot[cs->active] = slot;
+	cs->last_slot = slot;
+}  // }}}
+
+
+void calstore_save() {  // {{{
+	// Replaces int_eeprom_write_block() calls for sensor.e.
+	// Saves sensor.e as the active profile.
+	//
+	// This function is non-blocking.
+
+	calstore.profiles[calstore.active] = sensor.e;
+	calstore.dirty = 1;
+	calstore_poll();
+}  // }}}
+
+
+void calstore_switch_profile(uchar profile) {  // {{{
+	// Makes another profile active. The change is also saved, so that this
+	// profile will still be active after the next boot.
+	//
+	// This function is non-blocking.
+
+	calstore.active = profile;
+	sensor.e = calstore.profiles[profile];
+	calstore.dirty = 1;
+	calstore_poll();
+}  // }}}
+
+#endif  // ENABLE_CALIBRATION_STORE
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
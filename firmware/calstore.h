@@ -0,0 +1,85 @@
+/* Name: calstore.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __calstore_h_included__
+#define __calstore_h_included__
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "common.h"
+#include "sensor.h"
+
+
+#if ENABLE_CALIBRATION_STORE
+
+// Number of calibration profiles (e.g. different desks or monitors).
+// Their names are in calstore.c.
+#define CALSTORE_PROFILES  3
+
+// Number of record slots in the EEPROM. Each one takes 39 bytes, and the
+// total must fit into the EEPROM, together with eeprom_sensor (32 bytes,
+// still used for migrating the old calibration). More slots spread the
+// wear over more cells.
+#if E2END >= 1023
+// ATmega328
+#define CALSTORE_SLOTS     25
+#else
+// ATmega8/88/168, 512 bytes
+#define CALSTORE_SLOTS     12
+#endif
+
+// Must be incremented whenever SensorEepromData or CalibrationRecord
+// changes, so that old records are ignored.
+#define CALSTORE_VERSION   1
+
+#define CALSTORE_NO_SLOT   0xFF
+
+typedef struct CalibrationRecord {
+	uchar version;
+	uchar profile;
+	// The newest record of each profile is the valid one
+	unsigned long sequence;
+	SensorEepromData data;
+	// CRC16 of all the previous fields
+	unsigned int crc;
+} CalibrationRecord;
+
+typedef struct CalibrationStore {
+	// RAM cache of all profiles. The active one is also at sensor.e.
+	SensorEepromData profiles[CALSTORE_PROFILES];
+	// Slot of the newest record of each profile. These slots are never
+	// overwritten, so a torn write only loses the new record.
+	uchar profile_slot[CALSTORE_PROFILES];
+
+	uchar active;
+
+	// The last written record
+	uchar last_slot;
+	unsigned long sequence;
+
+	// A save has been requested, but the previous record is still being
+	// written.
+	uchar dirty;
+
+	// Being written to the EEPROM
+	CalibrationRecord record;
+} CalibrationStore;
+
+extern CalibrationStore calstore;
+
+extern PGM_P const calstore_profile_names[CALSTORE_PROFILES];
+
+
+void calstore_load();
+void calstore_save();
+void calstore_poll();
+void calstore_switch_profile(uchar profile);
+
+#endif  // ENABLE_CALIBRATION_STORE
+
+
+#endif  // __calstore_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Round-trip check of the tables generated by gen_layouts.py:
+#   ./check_layouts.py keyboard_layouts.h
+# Also run by "make layouts".
+#
+# For each char_to_key[] table, every printable ASCII char is "typed" with
+# the key and modifiers from the table, and translated back into a char by
+# the layout description (layouts/*.txt), the way the host would do it. A
+# dead key must be marked with MOD_DEAD_KEY, because the firmware follows
+# it by a space. The check fails if any char comes back different.
+#
+# This does not share the char -> key logic of gen_layouts.py, only the
+# parsing of the layout descriptions, so it catches mistakes in both the
+# generator and the generated file.
+
+from __future__ import print_function
+
+import re
+import sys
+
+from gen_layouts import LEVELS, PRINTABLE, parse_layout
+
+
+LAYOUT_RE = re.compile(r'^#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_(\w+)$')
+SOURCE_RE = re.compile(r'^// From (\S+)$')
+ENTRY_RE = re.compile(r'^\t\{(\w+)\s*,\s*([\w |]+?)\s*\}[, ] // ')
+
+
+def read_tables(path):
+    # Returns a list of (name, source, [(key, [modifiers]), ...])
+    tables = []
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\n')
+            match = LAYOUT_RE.match(line)
+            if match:
+                tables.append((match.group(1), None, []))
+                continue
+            match = SOURCE_RE.match(line)
+            if match and tables:
+                name, source, entries = tables[-1]
+                tables[-1] = (name, match.group(1), entries)
+                continue
+            match = ENTRY_RE.match(line)
+            if match and tables:
+                modifiers = [m.strip() for m in match.group(2).split('|')]
+                tables[-1][2].append((match.group(1), [m for m in modifiers if m != '0']))
+    return tables
+
+
+def check_table(name, source, entries):
+    # Returns a list of error messages
+    errors = []
+    chars = [' '] + PRINTABLE
+    if len(entries) != len(chars):
+        return ['{0}: {1} entries, expected {2}'.format(name, len(entries), len(chars))]
+
+    model = parse_layout(source)
+    for char, (key, modifiers) in zip(chars, entries):
+        if char == ' ':
+            if (key, modifiers) != ('KEY_SPACE', []):
+                errors.append('{0}: space is not KEY_SPACE'.format(name))
+            continue
+
+        dead = 'MOD_DEAD_KEY' in modifiers
+        level_modifiers = [m for m in modifiers if m != 'MOD_DEAD_KEY']
+        if level_modifiers not in LEVELS:
+            errors.append('{0}: {1!r} uses unexpected modifiers {2}'.format(name, char, modifiers))
+            continue
+        level = LEVELS.index(level_modifiers)
+
+        typed = model.get((key, level))
+        if typed is None:
+            errors.append('{0}: {1!r} is typed by {2} at level {3}, which types nothing'.format(name, char, key, level))
+        elif typed != (char, dead):
+            errors.append('{0}: {1!r} is typed by {2} at level {3}, which types {4!r}{5}'.format(
+                name, char, key, level, typed[0], ' (dead key)' if typed[1] else ''))
+    return errors
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('Usage: {0} keyboard_layouts.h'.format(sys.argv[0]))
+
+    tables = read_tables(sys.argv[1])
+    if not tables:
+        sys.exit('{0}: no layout tables found'.format(sys.argv[1]))
+
+    errors = []
+    for name, source, entries in tables:
+        errors.extend(check_table(name, source, entries))
+
+    if errors:
+        sys.exit('\n'.join(errors))
+    print('{0} layouts: all printable ASCII chars round-trip'.format(len(tables)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,82 @@
+/* Name: clock.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Free-running device clock, built on top of the Timer0 1.365ms ticker.
+ *
+ * Timer0 has no interrupt enabled, and its overflow flag is polled from the
+ * main loop by clock_poll(). Thus, clock_ticks may lag behind if a single
+ * iteration of the main loop takes longer than 1.365ms. That is fine for
+ * the intended use, which is timestamping things for later analysis.
+ *
+ * The exception is CLOCK_USE_ISR. ENABLE_IDLE_SLEEP needs an interrupt to
+ * wake up the CPU at every tick, and ENABLE_SCHEDULER needs
+ * clock_timestamp() to keep counting during an iteration of the main loop
+ * that takes several ticks, in order to measure it. ENABLE_PIN_CHANGE_BUTTONS
+ * reads clock_isr_ticks from its own interrupt, where clock_ticks would lag.
+ * In that case, the interrupt only increments clock_isr_ticks, and
+ * clock_poll() compares it with clock_ticks.
+ */
+
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "clock.h"
+
+
+#if CLOCK_ENABLE_TICKS
+
+unsigned int clock_ticks;
+
+#if CLOCK_USE_ISR
+volatile uchar clock_isr_ticks;
+
+
+// ISR_NOBLOCK re-enables the interrupts as the very first instruction, so
+// that this interrupt never delays the USB one (V-USB requires the USB
+// interrupt to start within a few cycles).
+ISR(TIMER0_OVF_vect, ISR_NOBLOCK) {  // {{{
+	clock_isr_ticks++;
+}  // }}}
+#endif
+
+
+unsigned int clock_timestamp() {  // {{{
+	// Returns the current time, in units of 5.333us (one TCNT0 step).
+	// The value wraps around every 349.5ms.
+	//
+	// The low byte comes from TCNT0, the high byte comes from clock_ticks.
+	// If Timer0 has overflowed but clock_poll() has not seen it yet, the
+	// pending overflow is taken into account. The "& 0x80" test avoids
+	// counting an overflow that happened right after reading TCNT0.
+
+	uchar low;
+	uchar high;
+
+#if CLOCK_USE_ISR
+	// The interrupt may run between reading both bytes. In that case, just
+	// read them again. TOV0 can only be pending if the interrupts are
+	// disabled (e.g. when called from inside another interrupt).
+	do {
+		high = clock_isr_ticks;
+		low = TCNT0;
+	} while (high != clock_isr_ticks);
+#else
+	low = TCNT0;
+	high = clock_ticks;
+#endif
+	if ((TIFR & (1<<TOV0)) && !(low & 0x80)) {
+		high++;
+	}
+
+	return (high << 8) | low;
+}  // }}}
+
+#endif  // CLOCK_ENABLE_TICKS
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
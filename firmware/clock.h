@@ -0,0 +1,92 @@
+/* Name: clock.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __clock_h_included__
+#define __clock_h_included__
+
+#include <avr/io.h>
+#include "common.h"
+#include "mcucompat.h"
+
+
+// The tick counter is only needed by a few optional features, so it is not
+// compiled unless one of them is enabled. This saves a few bytes of flash.
+#define CLOCK_ENABLE_TICKS (ENABLE_REPORT_TIMESTAMPS || ENABLE_POLL_SYNC || ENABLE_SCHEDULER || ENABLE_IDLE_SLEEP || ENABLE_ASYNC_STARTUP || ENABLE_DIAGNOSTICS || ENABLE_BUS_RECOVERY || ENABLE_PIN_CHANGE_BUTTONS)
+
+// The Timer0 overflow interrupt is only needed to wake up the CPU
+// (ENABLE_IDLE_SLEEP), to measure long iterations of the main loop
+// (ENABLE_SCHEDULER) and to timestamp the button edges from inside the pin
+// change interrupt (ENABLE_PIN_CHANGE_BUTTONS), see clock.c.
+#define CLOCK_USE_ISR (ENABLE_IDLE_SLEEP || ENABLE_SCHEDULER || ENABLE_PIN_CHANGE_BUTTONS)
+
+
+// Timer0 is configured (at hardware_init()) with prescaler 64. At 12MHz,
+// one TCNT0 step is 5.333us, and one overflow (a "tick") is 1.365ms.
+// This macro converts milliseconds to clock_timestamp() units.
+#define CLOCK_MS(ms) ((unsigned int) ((ms) * (F_CPU / 64 / 100) / 10))
+
+
+#if CLOCK_ENABLE_TICKS
+// Incremented at every Timer0 overflow (as seen by clock_poll())
+extern unsigned int clock_ticks;
+
+unsigned int clock_timestamp();
+#endif
+
+#if CLOCK_USE_ISR
+// With CLOCK_USE_ISR, the Timer0 overflow interrupt is enabled, and the
+// hardware clears TOV0 when the interrupt runs. This is incremented by the
+// interrupt instead.
+extern volatile uchar clock_isr_ticks;
+#endif
+
+
+static inline uchar clock_poll() {  // {{{
+	// Must be called at every iteration of the main loop.
+	// Returns 1 if Timer0 has overflowed since the last call.
+#if CLOCK_USE_ISR
+	// If this iteration took more than one tick, the remaining ones will be
+	// seen by the next calls.
+	if (clock_isr_ticks != (uchar) clock_ticks) {
+		clock_ticks++;
+		return 1;
+	} else {
+		return 0;
+	}
+#else
+	if (TIFR & (1<<TOV0)) {
+		// Resetting the Timer0
+		// Setting this bit to one will clear it.
+		TIFR = 1<<TOV0;
+#if CLOCK_ENABLE_TICKS
+		clock_ticks++;
+#endif
+		return 1;
+	} else {
+		return 0;
+	}
+#endif
+}  // }}}
+
+
+#if CLOCK_ENABLE_TICKS
+static inline void clock_poll_no_interrupts() {  // {{{
+	// Like clock_poll(), for busy waits before the interrupts are enabled
+	// (e.g. at hardware_init()). The Timer0 interrupt can't run yet, so
+	// TOV0 is always polled, even with CLOCK_USE_ISR.
+	if (TIFR & (1<<TOV0)) {
+		TIFR = 1<<TOV0;
+		clock_ticks++;
+#if CLOCK_USE_ISR
+		clock_isr_ticks++;
+#endif
+	}
+}  // }}}
+#endif
+
+
+#endif  // __clock_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -15,6 +15,10 @@
 // http://www.tty1.net/blog/2008-04-29-avr-gcc-optimisations_en.html
 #define FIX_POINTER(_ptr) __asm__ __volatile__("" : "=b" (_ptr) : "0" (_ptr))
 
+// Compile-time check, usable outside functions. The name only shows up in
+// the error message, which complains about a negative array size.
+#define STATIC_ASSERT(cond, name) typedef char static_assert_##name[(cond) ? 1 : -1]
+
 
 #endif  // __common_h_included__
 
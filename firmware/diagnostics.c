@@ -0,0 +1,36 @@
+/* Name: diagnostics.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Diagnostics feature report (ID 5).
+ *
+ * Holds the time (in Timer0 ticks since power-on) of a few startup events:
+ * end of the USB reset, sensor configured (or given up), USB configured by
+ * the host, and the first mouse report carrying a valid position. The last
+ * one is the time-to-first-report figure of a cold start, as long as the
+ * switch is held while plugging the device.
+ *
+ * It also counts the sensor communication errors and what has been done to
+ * recover from them (see busrecovery.c), and the press-to-report latency of
+ * the buttons (see buttons.c).
+ *
+ * The events are stored with DIAGNOSTICS_MARK(), and the counters are
+ * incremented with DIAGNOSTICS_COUNT(), from wherever they happen.
+ * The report is read by host_tools/diagnostics_dump.py.
+ */
+
+
+#include "diagnostics.h"
+
+
+#if ENABLE_DIAGNOSTICS
+
+DiagnosticsReport diagnostics_report;
+
+#endif  // ENABLE_DIAGNOSTICS
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,89 @@
+/* Name: diagnostics.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __diagnostics_h_included__
+#define __diagnostics_h_included__
+
+#include "common.h"
+#include "clock.h"
+#include "hidreport.h"
+
+
+// Bits of DiagnosticsReport.events
+#define DIAG_USB_RESET_DONE    (1<<0)
+#define DIAG_SENSOR_READY      (1<<1)
+#define DIAG_SENSOR_MISSING    (1<<2)
+#define DIAG_USB_CONFIGURED    (1<<3)
+#define DIAG_FIRST_REPORT      (1<<4)
+
+
+#if ENABLE_DIAGNOSTICS
+
+typedef struct DiagnosticsReport {
+	uchar report_id;
+
+	// Which of the startup events below have already happened
+	uchar events;
+
+	// Startup events, in Timer0 ticks (1.365ms) since power-on
+	unsigned int usb_reset_done;
+	unsigned int sensor_ready;      // Also used for DIAG_SENSOR_MISSING
+	unsigned int usb_configured;
+	unsigned int first_report;      // First mouse report with a position
+
+	// How many times the sensor identification was read at startup
+	uchar sensor_probe_attempts;
+
+	// Error counters
+	unsigned int twi_errors;      // Failed sensor readings
+	unsigned int twi_timeouts;    // TWI stuck for too long
+	unsigned int bus_recoveries;  // See busrecovery.c
+	unsigned int sensor_reinits;  // Successful reconfigurations
+	unsigned int lost_samples;    // Sensor readings not done or failed
+
+	// Time from a button press to the report carrying it being queued, in
+	// clock_timestamp() units (5.333us). Only measured with
+	// ENABLE_PIN_CHANGE_BUTTONS.
+	unsigned int button_latency_last;
+	unsigned int button_latency_max;
+
+	// Bytes of RAM never reached by the stack since power-on, updated when
+	// this report is read. Only measured with ENABLE_STACK_MONITOR (see
+	// stackmon.c), otherwise it stays at 0xFFFF.
+	unsigned int stack_unused;
+} DiagnosticsReport;
+
+extern DiagnosticsReport diagnostics_report;
+
+
+#define init_diagnostics() do{ \
+		diagnostics_report.report_id = DIAGNOSTICS_REPORT_ID; \
+		diagnostics_report.stack_unused = 0xFFFF; \
+	}while(0)
+
+// Stores the current time into the field, but only the first time the
+// event happens.
+#define DIAGNOSTICS_MARK(event, field) do{ \
+		if (!(diagnostics_report.events & (event))) { \
+			diagnostics_report.events |= (event); \
+			diagnostics_report.field = clock_ticks; \
+		} \
+	}while(0)
+
+// Increments one of the counters
+#define DIAGNOSTICS_COUNT(field) do{ diagnostics_report.field++; }while(0)
+
+#else
+
+// Compiled out
+#define DIAGNOSTICS_MARK(event, field) do{ }while(0)
+#define DIAGNOSTICS_COUNT(field) do{ }while(0)
+
+#endif
+
+
+#endif  // __diagnostics_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
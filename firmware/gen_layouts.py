@@ -0,0 +1,192 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Compiles the keyboard layout descriptions (layouts/*.txt) into
+# keyboard_layouts.h, which has one char_to_key[] table per layout:
+#   ./gen_layouts.py layouts/*.txt > keyboard_layouts.h
+# or simply:
+#   make layouts
+#
+# The firmware types text by pressing keys, and the host translates them
+# into chars according to its own layout. So, the table must be built for
+# the same layout as the host, selected by KEYBOARD_LAYOUT at the Makefile.
+#
+# Each line of a layout description is a key, followed by the chars typed
+# by that key alone, with shift, and with AltGr:
+#   KEY_2   2   @
+#   KEY_7   7   /   {
+# A char is written as itself, "--" means that position is not useful
+# (nothing, or a non-ASCII char), and "dead:X" is a dead key, which types
+# X when followed by a space. Trailing "--" can be left out. Space, Tab and
+# Enter are the same in all layouts, and are not listed.
+#
+# Every printable ASCII char must be typeable, otherwise this script fails,
+# so that no char is silently dropped by the firmware. When a char can be
+# typed in more than one way, the one with fewer modifiers is used, and a
+# plain key is preferred over a dead key.
+
+from __future__ import print_function
+
+import argparse
+import os.path
+import sys
+
+
+# Must match the key usage values at keyemu.c
+KEYS = set(
+    ['KEY_' + c for c in 'ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789'] + [
+        'KEY_MINUS',
+        'KEY_EQUAL',
+        'KEY_LEFT_BRACKET',
+        'KEY_RIGHT_BRACKET',
+        'KEY_BACKSLASH',
+        'KEY_NON_US_HASH',
+        'KEY_SEMICOLON',
+        'KEY_APOSTROPHE',
+        'KEY_GRAVE',
+        'KEY_COMMA',
+        'KEY_PERIOD',
+        'KEY_SLASH',
+        'KEY_NON_US_BACKSLASH',
+        'KEY_INTERNATIONAL1',
+    ]
+)
+
+# Modifiers of each column
+LEVELS = [
+    [],
+    ['MOD_SHIFT_LEFT'],
+    ['MOD_ALT_RIGHT'],
+]
+
+PRINTABLE = [chr(c) for c in range(0x21, 0x7F)]
+
+
+def parse_layout(path):
+    # Returns a dict of (key, level) -> (char, dead)
+    model = {}
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+
+            def error(message):
+                sys.exit('{0}:{1}: {2}'.format(path, number, message))
+
+            tokens = line.split()
+            key = tokens[0]
+            if key not in KEYS:
+                error('unknown key ' + key)
+            if any(k == key for k, level in model):
+                error('duplicate key ' + key)
+            if len(tokens) - 1 > len(LEVELS):
+                error('too many columns')
+
+            for level, token in enumerate(tokens[1:]):
+                if token == '--':
+                    continue
+                dead = token.startswith('dead:')
+                if dead:
+                    token = token[len('dead:'):]
+                if len(token) != 1 or token not in PRINTABLE:
+                    error('invalid char "{0}"'.format(token))
+                model[(key, level)] = (token, dead)
+    return model
+
+
+def build_table(name, model):
+    # Returns a dict of char -> (key, level, dead)
+    table = {}
+    for (key, level), (char, dead) in model.items():
+        best = table.get(char)
+        if best is None or (level, dead, key) < (best[1], best[2], best[0]):
+            table[char] = (key, level, dead)
+
+    missing = [c for c in PRINTABLE if c not in table]
+    if missing:
+        sys.exit('Layout {0} cannot type: {1}'.format(name, ' '.join(missing)))
+
+    return table
+
+
+def c_char_comment(char):
+    # A backslash at the end of a // comment would continue it on the next line
+    return {' ': 'SPACE', '\\': 'BACKSLASH'}.get(char, char)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compiles layouts/*.txt into keyboard_layouts.h')
+    parser.add_argument('layouts', nargs='+', metavar='layout.txt')
+    options = parser.parse_args()
+
+    layouts = []
+    for path in sorted(options.layouts):
+        name = os.path.splitext(os.path.basename(path))[0].upper()
+        model = parse_layout(path)
+        layouts.append((name, path, build_table(name, model)))
+
+    out = []
+    out.append('/* Name: keyboard_layouts.h')
+    out.append(' *')
+    out.append(' * Generated by gen_layouts.py from the layouts directory, do not edit.')
+    out.append(' */')
+    out.append('')
+    out.append('#ifndef __keyboard_layouts_h_included__')
+    out.append('#define __keyboard_layouts_h_included__')
+    out.append('')
+    out.append('')
+    out.append('// Values of KEYBOARD_LAYOUT')
+    out.append('// Zero is not used, so that an unknown name is an error.')
+    out.append('#define KEYBOARD_LAYOUT_BUILTIN 1')
+    for number, (name, path, table) in enumerate(layouts, 2):
+        out.append('#define KEYBOARD_LAYOUT_{0} {1}'.format(name, number))
+    out.append('')
+    out.append('')
+    out.append('#if KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_BUILTIN')
+    out.append('// The smaller US table at keyemu.c is used')
+    out.append('#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 0')
+
+    for name, path, table in layouts:
+        chars = [' '] + PRINTABLE
+        has_dead = any(table[c][2] for c in PRINTABLE)
+
+        out.append('')
+        out.append('#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_{0}'.format(name))
+        out.append('// From {0}'.format(path))
+        out.append('#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS {0}'.format(1 if has_dead else 0))
+        out.append('')
+        out.append('// Chars from \' \' to \'~\'')
+        out.append('static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{')
+        entries = []
+        for char in chars:
+            if char == ' ':
+                key, modifiers = 'KEY_SPACE', []
+            else:
+                key, level, dead = table[char]
+                modifiers = list(LEVELS[level])
+                if dead:
+                    modifiers.append('MOD_DEAD_KEY')
+            entries.append((
+                '\t{{{0:<20}, {1:<29}}}'.format(key, ' | '.join(modifiers) or '0'),
+                c_char_comment(char)
+            ))
+        for index, (entry, comment) in enumerate(entries):
+            comma = ',' if index < len(entries) - 1 else ' '
+            out.append('{0}{1} // {2}'.format(entry, comma, comment))
+        out.append('};  // }}}')
+
+    out.append('')
+    out.append('#else')
+    out.append('#error "Unknown KEYBOARD_LAYOUT, see the layouts directory"')
+    out.append('#endif')
+    out.append('')
+    out.append('')
+    out.append('#endif  // __keyboard_layouts_h_included____')
+
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,339 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Compiles the menu description (menu_tree.txt) into menu_tree.h:
+#   ./gen_menu.py menu_tree.txt > menu_tree.h
+# or simply:
+#   make menu
+#
+# The output has:
+# * the ids of all menus and widgets (UI_*_MENU and UI_*_WIDGET);
+# * UI_STACK_SIZE, the deepest chain of ui_enter_widget() calls;
+# * the item strings and the PROGMEM MenuItem tables of each menu, plus
+#   menu_loading[], which are read directly from flash by menu.c.
+#
+# Menu items may depend on ENABLE_* options, each one is wrapped in its own
+# #if block. This way, the output does not depend on the current
+# configuration. The item numbers ("1.2.") are not part of the strings,
+# since they depend on which items exist: menu.c types them from the UI
+# stack, so the strings start with the space that follows the number.
+
+from __future__ import print_function
+
+import argparse
+import itertools
+import re
+import shlex
+import sys
+
+
+# Widget ids start here, menu ids must be below it
+FIRST_WIDGET_ID = 0x10
+
+CONDITION_TOKEN_RE = re.compile(r'\s*(&&|\|\||!|\(|\)|[A-Za-z_]\w*)')
+
+
+class MenuItem(object):
+    def __init__(self, kind, target, long_text, short_text, condition, c_condition, line):
+        self.kind = kind  # 'menu', 'back' or 'widget'
+        self.target = target
+        self.long_text = long_text
+        self.short_text = short_text
+        self.condition = condition  # Python expression
+        self.c_condition = c_condition  # As written in menu_tree.txt
+        self.line = line
+
+
+def error(line, message):
+    sys.exit('menu_tree.txt:{0}: {1}'.format(line, message))
+
+
+def parse_condition(text, line):
+    # Converts a C preprocessor condition into a Python expression.
+    # Returns the expression and the names used by it.
+    tokens = []
+    names = set()
+    pos = 0
+    text = text.strip()
+    while pos < len(text):
+        match = CONDITION_TOKEN_RE.match(text, pos)
+        if not match:
+            error(line, 'invalid condition: ' + text)
+        token = match.group(1)
+        pos = match.end()
+        if token == '&&':
+            tokens.append('and')
+        elif token == '||':
+            tokens.append('or')
+        elif token == '!':
+            tokens.append('not')
+        elif token in '()':
+            tokens.append(token)
+        else:
+            names.add(token)
+            tokens.append('env[{0!r}]'.format(token))
+    return ' '.join(tokens), names
+
+
+def parse(path):
+    menus = []      # List of (name, [MenuItem])
+    widgets = []    # In order of appearance
+    flags = set(['ENABLE_FULL_MENU'])
+
+    current = None
+    with open(path) as f:
+        for number, text in enumerate(f, 1):
+            text = text.strip()
+            if not text or text.startswith('#'):
+                continue
+
+            words = text.split(None, 1)
+            if words[0] == 'menu':
+                name = words[1].strip()
+                if any(name == m[0] for m in menus):
+                    error(number, 'duplicate menu ' + name)
+                current = []
+                menus.append((name, current))
+                continue
+            if words[0] == 'widget':
+                name = words[1].strip()
+                if name in widgets:
+                    error(number, 'duplicate widget ' + name)
+                widgets.append(name)
+                continue
+            if current is None:
+                error(number, 'item outside of a menu')
+
+            action = words[0]
+            rest = shlex.split(words[1]) if len(words) > 1 else []
+            if not rest:
+                error(number, 'missing text')
+            texts = rest[0].split('|')
+            long_text = texts[0]
+            short_text = texts[1] if len(texts) > 1 else texts[0]
+
+            condition = None
+            c_condition = None
+            if len(rest) > 1:
+                if rest[1] != 'if' or len(rest) < 3:
+                    error(number, 'expected "if CONDITION" after the text')
+                c_condition = ' '.join(rest[2:])
+                condition, names = parse_condition(c_condition, number)
+                flags |= names
+
+            if action.startswith('>'):
+                if condition:
+                    error(number, 'submenus cannot be conditional')
+                item = MenuItem('menu', action[1:], long_text, short_text, condition, c_condition, number)
+            elif action == '<':
+                item = MenuItem('back', None, long_text, short_text, condition, c_condition, number)
+            else:
+                if action in widgets:
+                    error(number, 'duplicate widget ' + action)
+                widgets.append(action)
+                item = MenuItem('widget', action, long_text, short_text, condition, c_condition, number)
+
+            for c in long_text + short_text:
+                if ord(c) >= 0x80 or c in '"\\':
+                    error(number, 'unsupported character in the text')
+            current.append(item)
+
+    if not menus:
+        sys.exit('menu_tree.txt: no menus')
+
+    names = [m[0] for m in menus]
+    referenced = set()
+    for name, items in menus:
+        for item in items:
+            if item.kind == 'menu':
+                if item.target not in names:
+                    error(item.line, 'unknown menu ' + item.target)
+                if item.target in referenced or item.target == names[0]:
+                    error(item.line, 'menu {0} is opened from more than one place'.format(item.target))
+                referenced.add(item.target)
+    for name in names[1:]:
+        if name not in referenced:
+            sys.exit('menu_tree.txt: menu {0} is never opened'.format(name))
+
+    if len(menus) + 1 >= FIRST_WIDGET_ID:
+        sys.exit('menu_tree.txt: too many menus')
+    if FIRST_WIDGET_ID + len(widgets) > 0x100:
+        sys.exit('menu_tree.txt: too many widgets')
+
+    return menus, widgets, sorted(flags)
+
+
+def menu_id(name):
+    return 'UI_{0}_MENU'.format(name.upper())
+
+
+def widget_id(name):
+    return 'UI_{0}_WIDGET'.format(name)
+
+
+def c_escape(value):
+    return value.replace('\n', '\\n')
+
+
+def check_combination(menus, env):
+    # Checks that no menu is left without items in one combination of the
+    # options, and returns the stack depth needed by it.
+    by_name = dict(menus)
+
+    # How many ui_enter_widget() calls are stacked when each menu is active
+    # (the root menu is the first one).
+    depths = {menus[0][0]: 1}
+    order = [menus[0][0]]
+    stack_size = 1
+
+    for name in order:
+        items = [i for i in by_name[name] if not i.condition or eval(i.condition, {'env': env})]
+        if not items:
+            error(by_name[name][0].line if by_name[name] else 0, 'menu {0} has no items'.format(name))
+
+        for item in items:
+            if item.kind == 'menu':
+                depths[item.target] = depths[name] + 1
+                order.append(item.target)
+            if item.kind != 'back':
+                stack_size = max(stack_size, depths[name] + 1)
+
+    return stack_size
+
+
+def packed_string(name, prefix, text, suffix):
+    # The number is typed by menu.c right before the string
+    return 'PACKED_STRING({0}, "{1}");'.format(
+        name, c_escape(' {0}{1}{2}\n'.format(prefix, text, suffix))
+    )
+
+
+def generate_menu(name, items):
+    # Returns the lines with the strings and the table of one menu. The
+    # strings are named after the position of the item in menu_tree.txt,
+    # so that the names do not depend on the configuration.
+    lines = []
+    entries = []
+
+    lines.append('// {0} menu'.format(name.capitalize()))
+    for index, item in enumerate(items, 1):
+        string_name = '{0}_menu_{1}'.format(name, index)
+        if item.kind == 'menu':
+            suffix = ' >>'
+            prefix = ''
+            action = menu_id(item.target)
+        elif item.kind == 'back':
+            suffix = ''
+            prefix = '<< '
+            action = '0'
+        else:
+            suffix = ''
+            prefix = ''
+            action = widget_id(item.target)
+
+        if item.c_condition:
+            lines.append('#if {0}'.format(item.c_condition))
+            entries.append('#if {0}'.format(item.c_condition))
+        if item.long_text == item.short_text:
+            lines.append(packed_string(string_name, prefix, item.long_text, suffix))
+        else:
+            lines.append('#if ENABLE_FULL_MENU')
+            lines.append(packed_string(string_name, prefix, item.long_text, suffix))
+            lines.append('#else')
+            lines.append(packed_string(string_name, prefix, item.short_text, suffix))
+            lines.append('#endif')
+        entries.append('\t{{{0}, {1}}},'.format(string_name, action))
+        if item.c_condition:
+            lines.append('#endif')
+            entries.append('#endif')
+
+    lines.append('static const MenuItem {0}_menu_items[] PROGMEM = {{'.format(name))
+    lines.extend(entries)
+    lines.append('};')
+    lines.append('#define {0}_menu_total_items (sizeof({0}_menu_items) / sizeof(MenuItem))'.format(name))
+    lines.append('')
+
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compiles menu_tree.txt into menu_tree.h')
+    parser.add_argument('spec', metavar='menu_tree.txt')
+    options = parser.parse_args()
+
+    menus, widgets, flags = parse(options.spec)
+
+    out = []
+    out.append('/* Name: menu_tree.h')
+    out.append(' *')
+    out.append(' * Generated by gen_menu.py from menu_tree.txt, do not edit.')
+    out.append(' */')
+    out.append('')
+    out.append('#ifndef __menu_tree_h_included__')
+    out.append('#define __menu_tree_h_included__')
+    out.append('')
+    out.append('')
+
+    out.append('// Menus')
+    out.append('// Note: the ROOT (empty) menu must be ZERO')
+    out.append('#define UI_ROOT_MENU 0')
+    for number, (name, items) in enumerate(menus, 1):
+        out.append('#define {0} {1}'.format(menu_id(name), number))
+    out.append('')
+    out.append('// UI_MIN_MENU_ID must be ZERO')
+    out.append('#define UI_MIN_MENU_ID UI_ROOT_MENU')
+    out.append('#define UI_MAX_MENU_ID {0}'.format(menu_id(menus[-1][0])))
+    out.append('')
+    out.append('// Other widgets')
+    for number, name in enumerate(widgets, FIRST_WIDGET_ID):
+        out.append('#define {0} 0x{1:02X}'.format(widget_id(name), number))
+    out.append('')
+    out.append('')
+
+    out.append('// Root/empty menu')
+    out.append('// Yeah, this is just a "fake" menu with only one empty item.')
+    out.append('PACKED_STRING(empty_menu_1, "");')
+    out.append('static const MenuItem empty_menu_items[] PROGMEM = {')
+    out.append('\t{{empty_menu_1, {0}}}'.format(menu_id(menus[0][0])))
+    out.append('};')
+    out.append('')
+    out.append('// Error menu, for when something goes wrong')
+    out.append('PACKED_STRING(error_menu_1, " Menu error\\n");')
+    out.append('static const MenuItem error_menu_items[] PROGMEM = {')
+    out.append('\t{error_menu_1, 0}')
+    out.append('};')
+    out.append('')
+    out.append('')
+
+    for name, items in menus:
+        out.extend(generate_menu(name, items))
+    out.append('')
+
+    # The checks are done for every combination of the options used by the
+    # menu description
+    stack_size = 0
+    for values in itertools.product([1, 0], repeat=len(flags)):
+        env = dict(zip(flags, values))
+        stack_size = max(stack_size, check_combination(menus, env))
+
+    out.append('// Used by ui_load_menu_items(), indexed by the menu id plus one')
+    out.append('static const MenuLoadingInfo menu_loading[] PROGMEM = {')
+    entries = ['\t{error_menu_items, 1}', '\t{empty_menu_items, 1}']
+    for name, items in menus:
+        entries.append('\t{{{0}_menu_items, {0}_menu_total_items}}'.format(name))
+    out.append(',\n'.join(entries))
+    out.append('};')
+    out.append('')
+    out.append('// Deepest chain of ui_enter_widget() calls, starting from the root menu.')
+    out.append('// Widgets must call ui_pop_state() before entering another widget.')
+    out.append('#define UI_STACK_SIZE {0}'.format(stack_size))
+    out.append('')
+    out.append('')
+    out.append('#endif  // __menu_tree_h_included____')
+
+    print('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
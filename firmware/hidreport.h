@@ -0,0 +1,298 @@
+/* Name: hidreport.h
+ *
+ * The HID report descriptor of the device, and the size of each report.
+ *
+ * Each top-level collection (and each vendor-defined report) is declared
+ * here as a list of bytes. main.c joins them into usbHidReportDescriptor,
+ * and usbconfig.h counts their bytes with HID_LENGTH() to get
+ * USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH, so there is no length to be kept in
+ * sync by hand. main.c also checks, at compile time, that the structs of the
+ * reports have the sizes declared here.
+ *
+ * This file is also included by usbdrvasm.S (through usbconfig.h), so it
+ * must contain only preprocessor definitions. Comments inside the lists must
+ * be C comments, because a C++ comment would swallow the line continuation.
+ */
+
+#ifndef __hidreport_h_included__
+#define __hidreport_h_included__
+
+
+// Report IDs
+#define KEYBOARD_REPORT_ID     1
+#define MOUSE_REPORT_ID        2  // Also used by the pen digitizer
+#define VECTOR_REPORT_ID       3
+#define PROFILE_REPORT_ID      4
+#define DIAGNOSTICS_REPORT_ID  5
+
+
+////////////////////////////////////////////////////////////
+// Counting the bytes                                    {{{
+
+// Expands to the number of comma-separated items of the list, as a plain
+// number that can also be used in #if. Lists longer than 96 bytes must be
+// split, or the counter below must be extended.
+#define HID_LENGTH(...) HID_COUNT_ARGS_(__VA_ARGS__, HID_COUNT_ARGS_SEQ_)
+
+#define HID_COUNT_ARGS_(...) HID_COUNT_ARGS_N_(__VA_ARGS__)
+#define HID_COUNT_ARGS_N_( \
+		_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, \
+		_15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, \
+		_27, _28, _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, \
+		_39, _40, _41, _42, _43, _44, _45, _46, _47, _48, _49, _50, \
+		_51, _52, _53, _54, _55, _56, _57, _58, _59, _60, _61, _62, \
+		_63, _64, _65, _66, _67, _68, _69, _70, _71, _72, _73, _74, \
+		_75, _76, _77, _78, _79, _80, _81, _82, _83, _84, _85, _86, \
+		_87, _88, _89, _90, _91, _92, _93, _94, _95, _96, N, ...) N
+#define HID_COUNT_ARGS_SEQ_ \
+		96, 95, 94, 93, 92, 91, 90, 89, 88, 87, 86, 85, 84, 83, 82, 81, \
+		80, 79, 78, 77, 76, 75, 74, 73, 72, 71, 70, 69, 68, 67, 66, 65, \
+		64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, \
+		48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, \
+		32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, \
+		16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+
+// Size of a report in bytes, including the report ID, from the number of
+// bits declared by its REPORT_SIZE and REPORT_COUNT items
+#define HID_REPORT_BYTES(bits) (1 + (bits) / 8)
+
+// }}}
+
+////////////////////////////////////////////////////////////
+// Keyboard                                              {{{
+
+#define HID_KEYBOARD_COLLECTION \
+	0x05, 0x01,              /* USAGE_PAGE (Generic Desktop) */ \
+	0x09, 0x06,              /* USAGE (Keyboard) */ \
+	0xa1, 0x01,              /* COLLECTION (Application) */ \
+	0x85, KEYBOARD_REPORT_ID, /*  REPORT_ID (1) */ \
+	/* Modifier keys (they must come BEFORE the real keys) */ \
+	0x05, 0x07,              /*   USAGE_PAGE (Keyboard) */ \
+	0x19, 0xe0,              /*   USAGE_MINIMUM (Keyboard LeftControl) */ \
+	0x29, 0xe7,              /*   USAGE_MAXIMUM (Keyboard Right GUI) */ \
+	0x15, 0x00,              /*   LOGICAL_MINIMUM (0) */ \
+	0x25, 0x01,              /*   LOGICAL_MAXIMUM (1) */ \
+	0x75, 0x01,              /*   REPORT_SIZE (1) */ \
+	0x95, 0x08,              /*   REPORT_COUNT (8) */ \
+	0x81, 0x02,              /*   INPUT (Data,Var,Abs) */ \
+	/* Normal keys (same USAGE_PAGE and LOGICAL_MINIMUM as above) */ \
+	0x19, 0x00,              /*   USAGE_MINIMUM (Reserved (no event indicated)) */ \
+	0x29, 0x65,              /*   USAGE_MAXIMUM (Keyboard Application) */ \
+	0x25, 0x65,              /*   LOGICAL_MAXIMUM (101) */ \
+	0x75, 0x08,              /*   REPORT_SIZE (8) */ \
+	0x95, 0x01,              /*   REPORT_COUNT (1) */ \
+	0x81, 0x00,              /*   INPUT (Data,Ary,Abs) */ \
+	0xc0                     /* END_COLLECTION */
+
+// Modifier bits and one key
+#define KEYBOARD_REPORT_LENGTH  HID_REPORT_BYTES(1*8 + 8*1)
+
+// }}}
+
+////////////////////////////////////////////////////////////
+// Mouse or pen digitizer                                {{{
+
+#if ENABLE_DIGITIZER
+
+// Pen digitizer (used instead of the mouse)
+#define HID_MOUSE_COLLECTION \
+	0x05, 0x0d,              /* USAGE_PAGE (Digitizers) */ \
+	0x09, 0x02,              /* USAGE (Pen) */ \
+	0xa1, 0x01,              /* COLLECTION (Application) */ \
+	0x85, MOUSE_REPORT_ID,   /*   REPORT_ID (2) */ \
+	0x09, 0x20,              /*   USAGE (Stylus) */ \
+	0xa1, 0x00,              /*   COLLECTION (Physical) */ \
+	/* X, Y position (LOGICAL_MINIMUM is 0 by default) */ \
+	0x05, 0x01,              /*     USAGE_PAGE (Generic Desktop) */ \
+	0x09, 0x30,              /*     USAGE (X) */ \
+	0x09, 0x31,              /*     USAGE (Y) */ \
+	0x27, 0xff, 0xff, 0x00, 0x00, /*  LOGICAL_MAXIMUM (65535) */ \
+	0x75, 0x10,              /*     REPORT_SIZE (16) */ \
+	0x95, 0x02,              /*     REPORT_COUNT (2) */ \
+	0x81, 0x02,              /*     INPUT (Data,Var,Abs) */ \
+	/* Buttons and In Range */ \
+	0x05, 0x0d,              /*     USAGE_PAGE (Digitizers) */ \
+	0x09, 0x42,              /*     USAGE (Tip Switch) */ \
+	0x09, 0x44,              /*     USAGE (Barrel Switch) */ \
+	0x09, 0x5a,              /*     USAGE (Secondary Barrel Switch) */ \
+	0x09, 0x32,              /*     USAGE (In Range) */ \
+	0x25, 0x01,              /*     LOGICAL_MAXIMUM (1) */ \
+	0x75, 0x01,              /*     REPORT_SIZE (1) */ \
+	0x95, 0x04,              /*     REPORT_COUNT (4) */ \
+	0x81, 0x02,              /*     INPUT (Data,Var,Abs) */ \
+	/* Padding (same REPORT_SIZE and REPORT_COUNT as above) */ \
+	0x81, 0x03,              /*     INPUT (Cnst,Var,Abs) */ \
+	0xc0,                    /*   END_COLLECTION */ \
+	0xc0                     /* END_COLLECTION */
+
+// X, Y, buttons and In Range, padding
+#define MOUSE_REPORT_LENGTH  HID_REPORT_BYTES(16*2 + 1*4 + 1*4)
+
+#else  // ENABLE_DIGITIZER
+
+#define HID_MOUSE_POINTER \
+	0x05, 0x01,              /* USAGE_PAGE (Generic Desktop) */ \
+	0x09, 0x02,              /* USAGE (Mouse) */ \
+	0xa1, 0x01,              /* COLLECTION (Application) */ \
+	0x85, MOUSE_REPORT_ID,   /*   REPORT_ID (2) */ \
+	0x09, 0x01,              /*   USAGE (Pointer) */ \
+	0xa1, 0x00,              /*   COLLECTION (Physical) */ \
+	/* X, Y movement (LOGICAL_MINIMUM is 0 by default) */ \
+	0x09, 0x30,              /*     USAGE (X) */ \
+	0x09, 0x31,              /*     USAGE (Y) */ \
+	0x26, 0xff, 0x7f,        /*     LOGICAL_MAXIMUM (32767) */ \
+	0x75, 0x10,              /*     REPORT_SIZE (16) */ \
+	0x95, 0x02,              /*     REPORT_COUNT (2) */ \
+	0x81, 0x42,              /*     INPUT (Data,Var,Abs,Null) */ \
+	0xc0,                    /*   END_COLLECTION */ \
+	/* Buttons */ \
+	0x05, 0x09,              /*   USAGE_PAGE (Button) */ \
+	0x19, 0x01,              /*   USAGE_MINIMUM (Button 1) */ \
+	0x29, 0x03,              /*   USAGE_MAXIMUM (Button 3) */ \
+	0x25, 0x01,              /*   LOGICAL_MAXIMUM (1) */ \
+	0x75, 0x01,              /*   REPORT_SIZE (1) */ \
+	0x95, 0x03,              /*   REPORT_COUNT (3) */ \
+	0x81, 0x02               /*   INPUT (Data,Var,Abs) */
+
+#if ENABLE_REPORT_TIMESTAMPS
+
+#define HID_MOUSE_COLLECTION \
+	HID_MOUSE_POINTER, \
+	/* Sequence number (uses the 5 bits of padding after the buttons) */ \
+	0x06, 0x00, 0xff,        /*   USAGE_PAGE (Vendor Defined Page 1) */ \
+	0x09, 0x10,              /*   USAGE (Vendor Usage 0x10) */ \
+	0x25, 0x1f,              /*   LOGICAL_MAXIMUM (31) */ \
+	0x75, 0x05,              /*   REPORT_SIZE (5) */ \
+	0x95, 0x01,              /*   REPORT_COUNT (1) */ \
+	0x81, 0x02,              /*   INPUT (Data,Var,Abs) */ \
+	/* Device timestamp of the sensor sample */ \
+	0x09, 0x11,              /*   USAGE (Vendor Usage 0x11) */ \
+	0x27, 0xff, 0xff, 0x00, 0x00, /* LOGICAL_MAXIMUM (65535) */ \
+	0x75, 0x10,              /*   REPORT_SIZE (16) */ \
+	0x81, 0x02,              /*   INPUT (Data,Var,Abs) */ \
+	0xc0                     /* END_COLLECTION */
+
+// X, Y, buttons, sequence number, timestamp
+#define MOUSE_REPORT_LENGTH  HID_REPORT_BYTES(16*2 + 1*3 + 5*1 + 16*1)
+
+#else  // ENABLE_REPORT_TIMESTAMPS
+
+#define HID_MOUSE_COLLECTION \
+	HID_MOUSE_POINTER, \
+	/* Padding for the buttons (same REPORT_SIZE as above) */ \
+	0x95, 0x05,              /*   REPORT_COUNT (5) */ \
+	0x81, 0x03,              /*   INPUT (Cnst,Var,Abs) */ \
+	0xc0                     /* END_COLLECTION */
+
+// X, Y, buttons, padding
+#define MOUSE_REPORT_LENGTH  HID_REPORT_BYTES(16*2 + 1*3 + 1*5)
+
+#endif  // ENABLE_REPORT_TIMESTAMPS
+
+#endif  // ENABLE_DIGITIZER
+
+// }}}
+
+////////////////////////////////////////////////////////////
+// Vendor-defined reports                                {{{
+
+// The vendor-defined collection is only present if at least one of its
+// reports is enabled.
+#define HID_VENDOR_COLLECTION_BEGIN \
+	0x06, 0x00, 0xff,        /* USAGE_PAGE (Vendor Defined Page 1) */ \
+	0x09, 0x01,              /* USAGE (Vendor Usage 1) */ \
+	0xa1, 0x01               /* COLLECTION (Application) */
+
+#define HID_VENDOR_COLLECTION_END \
+	0xc0                     /* END_COLLECTION */
+
+#define HID_VECTOR_REPORT \
+	0x85, VECTOR_REPORT_ID,  /*   REPORT_ID (3) */ \
+	/* X, Y, Z vector from the sensor */ \
+	0x09, 0x02,              /*   USAGE (Vendor Usage 2) */ \
+	0x16, 0x00, 0x80,        /*   LOGICAL_MINIMUM (-32768) */ \
+	0x26, 0xff, 0x7f,        /*   LOGICAL_MAXIMUM (32767) */ \
+	0x75, 0x10,              /*   REPORT_SIZE (16) */ \
+	0x95, 0x03,              /*   REPORT_COUNT (3) */ \
+	0x81, 0x02,              /*   INPUT (Data,Var,Abs) */ \
+	/* Buttons and flags */ \
+	0x09, 0x03,              /*   USAGE (Vendor Usage 3) */ \
+	0x15, 0x00,              /*   LOGICAL_MINIMUM (0) */ \
+	0x26, 0xff, 0x00,        /*   LOGICAL_MAXIMUM (255) */ \
+	0x75, 0x08,              /*   REPORT_SIZE (8) */ \
+	0x95, 0x01,              /*   REPORT_COUNT (1) */ \
+	0x81, 0x02               /*   INPUT (Data,Var,Abs) */
+
+// X, Y, Z, flags
+#define VECTOR_REPORT_LENGTH  HID_REPORT_BYTES(16*3 + 8*1)
+
+// Feature reports are opaque blocks of bytes, described by their structs.
+// REPORT_COUNT does not include the report ID, and must fit in one byte.
+#define HID_FEATURE_BLOCK(id, usage, length) \
+	0x85, (id),              /*   REPORT_ID */ \
+	0x09, (usage),           /*   USAGE (Vendor Usage) */ \
+	0x15, 0x00,              /*   LOGICAL_MINIMUM (0) */ \
+	0x26, 0xff, 0x00,        /*   LOGICAL_MAXIMUM (255) */ \
+	0x75, 0x08,              /*   REPORT_SIZE (8) */ \
+	0x95, (length) - 1,      /*   REPORT_COUNT */ \
+	0xb1, 0x02               /*   FEATURE (Data,Var,Abs) */
+
+// Profiling counters, see ProfilingReport in profiling.h
+#define HID_PROFILE_REPORT \
+	HID_FEATURE_BLOCK(PROFILE_REPORT_ID, 0x04, sizeof(ProfilingReport))
+
+// Startup timings, see DiagnosticsReport in diagnostics.h
+#define HID_DIAGNOSTICS_REPORT \
+	HID_FEATURE_BLOCK(DIAGNOSTICS_REPORT_ID, 0x05, sizeof(DiagnosticsReport))
+
+// }}}
+
+////////////////////////////////////////////////////////////
+// Total length                                          {{{
+
+#if ENABLE_HOST_PROJECTION
+#define HID_VECTOR_REPORT_LENGTH       HID_LENGTH(HID_VECTOR_REPORT)
+#else
+#define HID_VECTOR_REPORT_LENGTH       0
+#endif
+
+#if ENABLE_PROFILING
+#define HID_PROFILE_REPORT_LENGTH      HID_LENGTH(HID_PROFILE_REPORT)
+#else
+#define HID_PROFILE_REPORT_LENGTH      0
+#endif
+
+#if ENABLE_DIAGNOSTICS
+#define HID_DIAGNOSTICS_REPORT_LENGTH  HID_LENGTH(HID_DIAGNOSTICS_REPORT)
+#else
+#define HID_DIAGNOSTICS_REPORT_LENGTH  0
+#endif
+
+#define HID_VENDOR_REPORTS_LENGTH ( \
+		HID_VECTOR_REPORT_LENGTH \
+		+ HID_PROFILE_REPORT_LENGTH \
+		+ HID_DIAGNOSTICS_REPORT_LENGTH \
+	)
+
+#if HID_VENDOR_REPORTS_LENGTH
+#define HID_VENDOR_COLLECTION_LENGTH ( \
+		HID_LENGTH(HID_VENDOR_COLLECTION_BEGIN) \
+		+ HID_VENDOR_REPORTS_LENGTH \
+		+ HID_LENGTH(HID_VENDOR_COLLECTION_END) \
+	)
+#else
+#define HID_VENDOR_COLLECTION_LENGTH   0
+#endif
+
+#define HID_REPORT_DESCRIPTOR_LENGTH ( \
+		HID_LENGTH(HID_KEYBOARD_COLLECTION) \
+		+ HID_LENGTH(HID_MOUSE_COLLECTION) \
+		+ HID_VENDOR_COLLECTION_LENGTH \
+	)
+
+// }}}
+
+
+#endif  // __hidreport_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,131 @@
+/* Name: idlesleep.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Puts the CPU in idle sleep at the end of each iteration of the main loop.
+ *
+ * Without this, the main loop spins all the time, calling usbPoll() and
+ * polling TIFR even when there is nothing to do. That wastes power and
+ * keeps the board noisier than needed, right next to the sensor.
+ *
+ * In idle mode, the CPU clock is stopped, but the peripherals (and their
+ * interrupts) keep running. Every event that the main loop waits for comes
+ * from an interrupt:
+ *
+ * - USB (INT0): V-USB receives packets inside the interrupt, and every
+ *   token from the host (including the ones answered with NAK while
+ *   usbPoll() has not processed the previous message) wakes up the CPU.
+ * - TWI: every step of the sensor communication.
+ * - EEPROM ready: see int_eeprom.c.
+ * - Timer0 overflow: enabled only in this mode (see clock.c), it wakes up
+ *   the CPU at every 1.365ms tick. Thus, anything else (buttons, menu
+ *   state machine, sensor timing) is delayed by at most one tick.
+ *
+ * Waking up from idle mode takes no extra clock cycles besides the normal
+ * interrupt response, so the V-USB timing is not affected. The other
+ * interrupts are either short (TWI, EEPROM) or ISR_NOBLOCK (Timer0).
+ *
+ * With ENABLE_PROFILING, the time spent sleeping is reported as the "sleep"
+ * stage, and host_tools/profile_dump.py prints how many iterations of the
+ * main loop ended in sleep and which fraction of the time was spent
+ * sleeping.
+ */
+
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+#include "usbdrv.h"
+
+#include "buttons.h"
+#include "clock.h"
+#include "idlesleep.h"
+#include "profiling.h"
+#include "sensor.h"
+
+
+#if ENABLE_IDLE_SLEEP
+
+
+#if USB_COUNT_SOF
+// USB suspend (no bus activity for more than 3ms) can only be detected with
+// USB_COUNT_SOF, which requires the USB interrupt on D- (see usbconfig.h).
+// When suspended, the sensor is put in idle mode and the continuous reading
+// is stopped; both are restored when the bus activity comes back. Meeting
+// the 500uA suspend current limit would also require power-down sleep,
+// which is not done here.
+
+IdleSleep idlesleep;
+
+// The host keeps the bus active with a keep-alive (low-speed EOP) every
+// 1ms frame. The USB specification says a device must enter the suspend
+// state after 3ms without activity. Using a bit more than that, as the
+// clock_timestamp() resolution is not that great.
+#define IDLESLEEP_SUSPEND_TIME  CLOCK_MS(5)
+
+static void idlesleep_check_suspend() {  // {{{
+	IdleSleep *is = &idlesleep;
+	FIX_POINTER(is);
+
+	unsigned int now;
+
+	now = clock_timestamp();
+
+	if (usbSofCount != is->last_sof) {
+		is->last_sof = usbSofCount;
+		is->last_activity = now;
+
+		if (is->suspended) {
+			// Resume
+			is->suspended = 0;
+			sensor_set_idle(0);
+			if (button.state & BUTTON_SWITCH) {
+				sensor_start_continuous_reading();
+			}
+		}
+	} else if (!is->suspended && now - is->last_activity > IDLESLEEP_SUSPEND_TIME) {
+		// Suspend
+		is->suspended = 1;
+		sensor_stop_continuous_reading();
+		sensor_set_idle(1);
+	}
+}  // }}}
+#endif
+
+
+void idlesleep_end_of_loop() {  // {{{
+	// Must be called at the end of each iteration of the main loop.
+	// Sleeps until the next interrupt.
+
+#if USB_COUNT_SOF
+	idlesleep_check_suspend();
+#endif
+
+	cli();
+	if (clock_isr_ticks != (uchar) clock_ticks) {
+		// A tick has happened during this iteration, after clock_poll().
+		// Not sleeping, so that it is handled right now instead of at the
+		// next tick.
+		sei();
+		return;
+	}
+
+	PROFILE_BEGIN(SLEEP);
+	sleep_enable();
+	// The instruction after SEI is always executed before any pending
+	// interrupt, so an interrupt that arrives right now will wake up the
+	// CPU instead of being lost.
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	PROFILE_END(SLEEP);
+}  // }}}
+
+#endif  // ENABLE_IDLE_SLEEP
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,36 @@
+/* Name: idlesleep.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __idlesleep_h_included__
+#define __idlesleep_h_included__
+
+#include <avr/sleep.h>
+#include "common.h"
+
+
+#if ENABLE_IDLE_SLEEP
+
+#if USB_COUNT_SOF
+// Suspend detection
+typedef struct IdleSleep {
+	uchar suspended:1;
+	uchar last_sof;
+	unsigned int last_activity;
+} IdleSleep;
+
+extern IdleSleep idlesleep;
+#endif
+
+
+#define init_idlesleep() do{ set_sleep_mode(SLEEP_MODE_IDLE); }while(0)
+
+void idlesleep_end_of_loop();
+
+#endif  // ENABLE_IDLE_SLEEP
+
+
+#endif  // __idlesleep_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -10,6 +10,23 @@
  *
  * The interrupt handler code is loosely based on "AVR104 Buffered Interrupt
  * Controlled EEPROM Writes on tinyAVR and megaAVR devices".
+ *
+ * The default implementation has a single buffer, so a new write overwrites
+ * whatever was still pending from the previous one.
+ *
+ * With ENABLE_EEPROM_QUEUE, there is no buffer at all. Instead, there is a
+ * small queue of {src, address, size} requests, and the bytes are taken
+ * from the RAM copy (src) at the moment they are written. Thus:
+ * - the RAM copy must not go away until it is written (in this project, it
+ *   is always sensor.e, which lives forever);
+ * - a request that overlaps (or touches) a pending one for the same RAM
+ *   copy is merged with it, and the latest values are written. Requests
+ *   for other bytes are queued separately, since the RAM between two
+ *   variables may not match the EEPROM between their EEMEM twins;
+ * - before writing each byte, the current EEPROM value is read, and the
+ *   byte is skipped if it already holds the target value. A write takes
+ *   about 8.5ms, while a read takes 4 clock cycles, so partial updates of a
+ *   block finish much faster.
  */
 
 
@@ -18,7 +35,26 @@
 #include <string.h>
 
 #include "int_eeprom.h"
+#include "mcucompat.h"
+
+
+#if ENABLE_EEPROM_QUEUE
 
+typedef struct IntEepromRequest {
+	const unsigned char *src;  // RAM
+	unsigned char *address;    // EEPROM
+	unsigned char size;
+} IntEepromRequest;
+
+// Ring buffer of requests. The one at eeprom_queue_head is being written,
+// and the interrupt handler advances it as the bytes are written.
+static IntEepromRequest eeprom_queue[INT_EEPROM_QUEUE_SIZE];
+static unsigned char eeprom_queue_head;
+static volatile unsigned char eeprom_queue_len;
+
+#define EEPROM_QUEUE_ENTRY(i) (&eeprom_queue[(eeprom_queue_head + (i)) & (INT_EEPROM_QUEUE_SIZE - 1)])
+
+#else
 
 // EEPROM destination address
 static void* eeprom_address;
@@ -29,6 +65,8 @@ static unsigned char eeprom_block_size;
 // The index of the next byte to be written
 static unsigned char eeprom_next_byte;
 
+#endif
+
 
 #define ENABLE_EE_RDY_INTERRUPT()   do { EECR |=  (1 << EERIE); } while(0)
 #define DISABLE_EE_RDY_INTERRUPT()  do { EECR &= ~(1 << EERIE); } while(0)
@@ -47,6 +85,138 @@ static void init_int_eeprom() {  // {{{
 */
 
 
+#if ENABLE_EEPROM_QUEUE
+
+static unsigned char int_eeprom_enqueue(
+		const unsigned char *src,
+		unsigned char *address,
+		unsigned char size) {  // {{{
+	// Returns 1 if the request has been queued (or merged), 0 if the queue
+	// is full. Must be called with EE_RDY interrupt disabled.
+
+	IntEepromRequest *req;
+	unsigned char *start;
+	unsigned char *end;
+	unsigned char i;
+
+	for (i = 0; i < eeprom_queue_len; i++) {
+		req = EEPROM_QUEUE_ENTRY(i);
+
+		// Same RAM copy, mapped to the same EEPROM block?
+		if ((unsigned int) req->src - (unsigned int) req->address
+		!= (unsigned int) src - (unsigned int) address) continue;
+
+		// Only if the ranges overlap or touch. Otherwise, the bytes between
+		// them could belong to something else, both in RAM and in EEPROM.
+		if (src > req->src + req->size || src + size < req->src) continue;
+
+		// Merging both requests
+		start = address < req->address ? address : req->address;
+		end = address + size > req->address + req->size ? address + size : req->address + req->size;
+		if (end - start > INT_EEPROM_MAX_MERGE) continue;
+
+		req->src = src - (address - start);
+		req->address = start;
+		req->size = end - start;
+		return 1;
+	}
+
+	if (eeprom_queue_len < INT_EEPROM_QUEUE_SIZE) {
+		req = EEPROM_QUEUE_ENTRY(eeprom_queue_len);
+		req->src = src;
+		req->address = address;
+		req->size = size;
+		eeprom_queue_len++;
+		return 1;
+	}
+
+	return 0;
+}  // }}}
+
+
+void int_eeprom_write_block(
+		const void * src,
+		void* address,
+		unsigned char size) {  // {{{
+	// Queues the writing of a block. The data is read from src later, when
+	// each byte is written.
+	//
+	// This function is non-blocking, unless the queue is full (which
+	// requires INT_EEPROM_QUEUE_SIZE separate blocks being written at the
+	// same time).
+
+	for (;;) {
+		// The interrupt handler must not touch the queue meanwhile.
+		DISABLE_EE_RDY_INTERRUPT();
+		if (int_eeprom_enqueue(src, address, size)) break;
+
+		// The queue is full, waiting for the interrupt handler.
+		ENABLE_EE_RDY_INTERRUPT();
+		while (eeprom_queue_len == INT_EEPROM_QUEUE_SIZE);
+	}
+	ENABLE_EE_RDY_INTERRUPT();
+}  // }}}
+
+
+unsigned char int_eeprom_busy() {  // {{{
+	// Returns nonzero while there is something to be written.
+	return eeprom_queue_len;
+}  // }}}
+
+
+ISR(EE_RDY_vect) {  // {{{
+	// This handler may loop over many bytes, so the interrupts are enabled
+	// again (for V-USB). However, EE_RDY keeps firing while the EEPROM is
+	// ready and EERIE is set, so it must be disabled first (that's why
+	// ISR_NOBLOCK can't be used here). The handler makes no function calls,
+	// so GCC only saves the few registers it uses before getting here.
+	DISABLE_EE_RDY_INTERRUPT();
+	sei();
+
+	//if ( SPMCR & (1 << SPMEN) ) // Is Self-Programming Currently Active?
+	//	return;                   // Yes, Return to main()
+
+	while (eeprom_queue_len) {
+		IntEepromRequest *req = EEPROM_QUEUE_ENTRY(0);
+		unsigned char value;
+
+		if (req->size == 0) {
+			// Done with this request, removing it from the queue
+			eeprom_queue_head = (eeprom_queue_head + 1) & (INT_EEPROM_QUEUE_SIZE - 1);
+			eeprom_queue_len--;
+			continue;
+		}
+
+		value = *req->src;
+		EEAR = (unsigned int) req->address;
+		req->src++;
+		req->address++;
+		req->size--;
+
+		// Reading the current value
+		EECR |= (1 << EERE);
+		if (EEDR == value) {
+			// Already there, skipping
+			continue;
+		}
+
+		EEDR = value;
+
+		// These two must be done within 4 cycles, so no interrupt can
+		// happen between them.
+		cli();
+		EECR |= (1 << EEMWE);  // Assert EEPROM Master Write Enable
+		EECR |= (1 << EEWE);   // Assert EEPROM Write Enable
+		sei();
+
+		// Coming back when this byte has been written
+		ENABLE_EE_RDY_INTERRUPT();
+		return;
+	}
+}  // }}}
+
+#else
+
 void int_eeprom_write_block(
 		const void * src,
 		void* address,
@@ -61,6 +231,12 @@ void int_eeprom_write_block(
 }  // }}}
 
 
+unsigned char int_eeprom_busy() {  // {{{
+	// Returns nonzero while there is something to be written.
+	return eeprom_block_size;
+}  // }}}
+
+
 ISR(EE_RDY_vect) {  // {{{
 	//if ( SPMCR & (1 << SPMEN) ) // Is Self-Programming Currently Active?
 	//	return;                   // Yes, Return to main()
@@ -81,5 +257,7 @@ ISR(EE_RDY_vect) {  // {{{
 	}
 }  // }}}
 
+#endif
+
 
 // vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -13,7 +13,23 @@
 // 1 XYZVector for the zero value (6 bytes)
 // 4 XYZVectors for the calibration corners (6 bytes each)
 // Total of 31
+// With ENABLE_CALIBRATION_STORE, a whole CalibrationRecord (39 bytes) is
+// written at once.
+#if ENABLE_CALIBRATION_STORE
+#define INT_EEPROM_BUFFER_SIZE   40
+#else
 #define INT_EEPROM_BUFFER_SIZE   32
+#endif
+
+#if ENABLE_EEPROM_QUEUE
+// Maximum number of pending requests. Overlapping (or touching) requests
+// for the same RAM copy are merged. Must be a power of 2.
+#define INT_EEPROM_QUEUE_SIZE    4
+
+// Requests are not merged if the result would be longer than this. It
+// must fit into an unsigned char.
+#define INT_EEPROM_MAX_MERGE     128
+#endif
 
 
 // Init does nothing
@@ -24,6 +40,8 @@ void int_eeprom_write_block(
 		void* address,
 		unsigned char size);
 
+unsigned char int_eeprom_busy();
+
 
 #endif  // __int_eeprom_h_included____
 
@@ -0,0 +1,544 @@
+/* Name: keyboard_layouts.h
+ *
+ * Generated by gen_layouts.py from the layouts directory, do not edit.
+ */
+
+#ifndef __keyboard_layouts_h_included__
+#define __keyboard_layouts_h_included__
+
+
+// Values of KEYBOARD_LAYOUT
+// Zero is not used, so that an unknown name is an error.
+#define KEYBOARD_LAYOUT_BUILTIN 1
+#define KEYBOARD_LAYOUT_BR_ABNT2 2
+#define KEYBOARD_LAYOUT_DE 3
+#define KEYBOARD_LAYOUT_FR 4
+#define KEYBOARD_LAYOUT_UK 5
+#define KEYBOARD_LAYOUT_US 6
+
+
+#if KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_BUILTIN
+// The smaller US table at keyemu.c is used
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 0
+
+#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_BR_ABNT2
+// From layouts/br_abnt2.txt
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 1
+
+// Chars from ' ' to '~'
+static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
+	{KEY_SPACE           , 0                            }, // SPACE
+	{KEY_1               , MOD_SHIFT_LEFT               }, // !
+	{KEY_GRAVE           , MOD_SHIFT_LEFT               }, // "
+	{KEY_3               , MOD_SHIFT_LEFT               }, // #
+	{KEY_4               , MOD_SHIFT_LEFT               }, // $
+	{KEY_5               , MOD_SHIFT_LEFT               }, // %
+	{KEY_7               , MOD_SHIFT_LEFT               }, // &
+	{KEY_GRAVE           , 0                            }, // '
+	{KEY_9               , MOD_SHIFT_LEFT               }, // (
+	{KEY_0               , MOD_SHIFT_LEFT               }, // )
+	{KEY_8               , MOD_SHIFT_LEFT               }, // *
+	{KEY_EQUAL           , MOD_SHIFT_LEFT               }, // +
+	{KEY_COMMA           , 0                            }, // ,
+	{KEY_MINUS           , 0                            }, // -
+	{KEY_PERIOD          , 0                            }, // .
+	{KEY_INTERNATIONAL1  , 0                            }, // /
+	{KEY_0               , 0                            }, // 0
+	{KEY_1               , 0                            }, // 1
+	{KEY_2               , 0                            }, // 2
+	{KEY_3               , 0                            }, // 3
+	{KEY_4               , 0                            }, // 4
+	{KEY_5               , 0                            }, // 5
+	{KEY_6               , 0                            }, // 6
+	{KEY_7               , 0                            }, // 7
+	{KEY_8               , 0                            }, // 8
+	{KEY_9               , 0                            }, // 9
+	{KEY_SLASH           , MOD_SHIFT_LEFT               }, // :
+	{KEY_SLASH           , 0                            }, // ;
+	{KEY_COMMA           , MOD_SHIFT_LEFT               }, // <
+	{KEY_EQUAL           , 0                            }, // =
+	{KEY_PERIOD          , MOD_SHIFT_LEFT               }, // >
+	{KEY_INTERNATIONAL1  , MOD_SHIFT_LEFT               }, // ?
+	{KEY_2               , MOD_SHIFT_LEFT               }, // @
+	{KEY_A               , MOD_SHIFT_LEFT               }, // A
+	{KEY_B               , MOD_SHIFT_LEFT               }, // B
+	{KEY_C               , MOD_SHIFT_LEFT               }, // C
+	{KEY_D               , MOD_SHIFT_LEFT               }, // D
+	{KEY_E               , MOD_SHIFT_LEFT               }, // E
+	{KEY_F               , MOD_SHIFT_LEFT               }, // F
+	{KEY_G               , MOD_SHIFT_LEFT               }, // G
+	{KEY_H               , MOD_SHIFT_LEFT               }, // H
+	{KEY_I               , MOD_SHIFT_LEFT               }, // I
+	{KEY_J               , MOD_SHIFT_LEFT               }, // J
+	{KEY_K               , MOD_SHIFT_LEFT               }, // K
+	{KEY_L               , MOD_SHIFT_LEFT               }, // L
+	{KEY_M               , MOD_SHIFT_LEFT               }, // M
+	{KEY_N               , MOD_SHIFT_LEFT               }, // N
+	{KEY_O               , MOD_SHIFT_LEFT               }, // O
+	{KEY_P               , MOD_SHIFT_LEFT               }, // P
+	{KEY_Q               , MOD_SHIFT_LEFT               }, // Q
+	{KEY_R               , MOD_SHIFT_LEFT               }, // R
+	{KEY_S               , MOD_SHIFT_LEFT               }, // S
+	{KEY_T               , MOD_SHIFT_LEFT               }, // T
+	{KEY_U               , MOD_SHIFT_LEFT               }, // U
+	{KEY_V               , MOD_SHIFT_LEFT               }, // V
+	{KEY_W               , MOD_SHIFT_LEFT               }, // W
+	{KEY_X               , MOD_SHIFT_LEFT               }, // X
+	{KEY_Y               , MOD_SHIFT_LEFT               }, // Y
+	{KEY_Z               , MOD_SHIFT_LEFT               }, // Z
+	{KEY_RIGHT_BRACKET   , 0                            }, // [
+	{KEY_NON_US_BACKSLASH, 0                            }, // BACKSLASH
+	{KEY_NON_US_HASH     , 0                            }, // ]
+	{KEY_APOSTROPHE      , MOD_SHIFT_LEFT | MOD_DEAD_KEY}, // ^
+	{KEY_MINUS           , MOD_SHIFT_LEFT               }, // _
+	{KEY_LEFT_BRACKET    , MOD_SHIFT_LEFT | MOD_DEAD_KEY}, // `
+	{KEY_A               , 0                            }, // a
+	{KEY_B               , 0                            }, // b
+	{KEY_C               , 0                            }, // c
+	{KEY_D               , 0                            }, // d
+	{KEY_E               , 0                            }, // e
+	{KEY_F               , 0                            }, // f
+	{KEY_G               , 0                            }, // g
+	{KEY_H               , 0                            }, // h
+	{KEY_I               , 0                            }, // i
+	{KEY_J               , 0                            }, // j
+	{KEY_K               , 0                            }, // k
+	{KEY_L               , 0                            }, // l
+	{KEY_M               , 0                            }, // m
+	{KEY_N               , 0                            }, // n
+	{KEY_O               , 0                            }, // o
+	{KEY_P               , 0                            }, // p
+	{KEY_Q               , 0                            }, // q
+	{KEY_R               , 0                            }, // r
+	{KEY_S               , 0                            }, // s
+	{KEY_T               , 0                            }, // t
+	{KEY_U               , 0                            }, // u
+	{KEY_V               , 0                            }, // v
+	{KEY_W               , 0                            }, // w
+	{KEY_X               , 0                            }, // x
+	{KEY_Y               , 0                            }, // y
+	{KEY_Z               , 0                            }, // z
+	{KEY_RIGHT_BRACKET   , MOD_SHIFT_LEFT               }, // {
+	{KEY_NON_US_BACKSLASH, MOD_SHIFT_LEFT               }, // |
+	{KEY_NON_US_HASH     , MOD_SHIFT_LEFT               }, // }
+	{KEY_APOSTROPHE      , MOD_DEAD_KEY                 }  // ~
+};  // }}}
+
+#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_DE
+// From layouts/de.txt
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 1
+
+// Chars from ' ' to '~'
+static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
+	{KEY_SPACE           , 0                            }, // SPACE
+	{KEY_1               , MOD_SHIFT_LEFT               }, // !
+	{KEY_2               , MOD_SHIFT_LEFT               }, // "
+	{KEY_NON_US_HASH     , 0                            }, // #
+	{KEY_4               , MOD_SHIFT_LEFT               }, // $
+	{KEY_5               , MOD_SHIFT_LEFT               }, // %
+	{KEY_6               , MOD_SHIFT_LEFT               }, // &
+	{KEY_NON_US_HASH     , MOD_SHIFT_LEFT               }, // '
+	{KEY_8               , MOD_SHIFT_LEFT               }, // (
+	{KEY_9               , MOD_SHIFT_LEFT               }, // )
+	{KEY_RIGHT_BRACKET   , MOD_SHIFT_LEFT               }, // *
+	{KEY_RIGHT_BRACKET   , 0                            }, // +
+	{KEY_COMMA           , 0                            }, // ,
+	{KEY_SLASH           , 0                            }, // -
+	{KEY_PERIOD          , 0                            }, // .
+	{KEY_7               , MOD_SHIFT_LEFT               }, // /
+	{KEY_0               , 0                            }, // 0
+	{KEY_1               , 0                            }, // 1
+	{KEY_2               , 0                            }, // 2
+	{KEY_3               , 0                            }, // 3
+	{KEY_4               , 0                            }, // 4
+	{KEY_5               , 0                            }, // 5
+	{KEY_6               , 0                            }, // 6
+	{KEY_7               , 0                            }, // 7
+	{KEY_8               , 0                            }, // 8
+	{KEY_9               , 0                            }, // 9
+	{KEY_PERIOD          , MOD_SHIFT_LEFT               }, // :
+	{KEY_COMMA           , MOD_SHIFT_LEFT               }, // ;
+	{KEY_NON_US_BACKSLASH, 0                            }, // <
+	{KEY_0               , MOD_SHIFT_LEFT               }, // =
+	{KEY_NON_US_BACKSLASH, MOD_SHIFT_LEFT               }, // >
+	{KEY_MINUS           , MOD_SHIFT_LEFT               }, // ?
+	{KEY_Q               , MOD_ALT_RIGHT                }, // @
+	{KEY_A               , MOD_SHIFT_LEFT               }, // A
+	{KEY_B               , MOD_SHIFT_LEFT               }, // B
+	{KEY_C               , MOD_SHIFT_LEFT               }, // C
+	{KEY_D               , MOD_SHIFT_LEFT               }, // D
+	{KEY_E               , MOD_SHIFT_LEFT               }, // E
+	{KEY_F               , MOD_SHIFT_LEFT               }, // F
+	{KEY_G               , MOD_SHIFT_LEFT               }, // G
+	{KEY_H               , MOD_SHIFT_LEFT               }, // H
+	{KEY_I               , MOD_SHIFT_LEFT               }, // I
+	{KEY_J               , MOD_SHIFT_LEFT               }, // J
+	{KEY_K               , MOD_SHIFT_LEFT               }, // K
+	{KEY_L               , MOD_SHIFT_LEFT               }, // L
+	{KEY_M               , MOD_SHIFT_LEFT               }, // M
+	{KEY_N               , MOD_SHIFT_LEFT               }, // N
+	{KEY_O               , MOD_SHIFT_LEFT               }, // O
+	{KEY_P               , MOD_SHIFT_LEFT               }, // P
+	{KEY_Q               , MOD_SHIFT_LEFT               }, // Q
+	{KEY_R               , MOD_SHIFT_LEFT               }, // R
+	{KEY_S               , MOD_SHIFT_LEFT               }, // S
+	{KEY_T               , MOD_SHIFT_LEFT               }, // T
+	{KEY_U               , MOD_SHIFT_LEFT               }, // U
+	{KEY_V               , MOD_SHIFT_LEFT               }, // V
+	{KEY_W               , MOD_SHIFT_LEFT               }, // W
+	{KEY_X               , MOD_SHIFT_LEFT               }, // X
+	{KEY_Z               , MOD_SHIFT_LEFT               }, // Y
+	{KEY_Y               , MOD_SHIFT_LEFT               }, // Z
+	{KEY_8               , MOD_ALT_RIGHT                }, // [
+	{KEY_MINUS           , MOD_ALT_RIGHT                }, // BACKSLASH
+	{KEY_9               , MOD_ALT_RIGHT                }, // ]
+	{KEY_GRAVE           , MOD_DEAD_KEY                 }, // ^
+	{KEY_SLASH           , MOD_SHIFT_LEFT               }, // _
+	{KEY_EQUAL           , MOD_SHIFT_LEFT | MOD_DEAD_KEY}, // `
+	{KEY_A               , 0                            }, // a
+	{KEY_B               , 0                            }, // b
+	{KEY_C               , 0                            }, // c
+	{KEY_D               , 0                            }, // d
+	{KEY_E               , 0                            }, // e
+	{KEY_F               , 0                            }, // f
+	{KEY_G               , 0                            }, // g
+	{KEY_H               , 0                            }, // h
+	{KEY_I               , 0                            }, // i
+	{KEY_J               , 0                            }, // j
+	{KEY_K               , 0                            }, // k
+	{KEY_L               , 0                            }, // l
+	{KEY_M               , 0                            }, // m
+	{KEY_N               , 0                            }, // n
+	{KEY_O               , 0                            }, // o
+	{KEY_P               , 0                            }, // p
+	{KEY_Q               , 0                            }, // q
+	{KEY_R               , 0                            }, // r
+	{KEY_S               , 0                            }, // s
+	{KEY_T               , 0                            }, // t
+	{KEY_U               , 0                            }, // u
+	{KEY_V               , 0                            }, // v
+	{KEY_W               , 0                            }, // w
+	{KEY_X               , 0                            }, // x
+	{KEY_Z               , 0                            }, // y
+	{KEY_Y               , 0                            }, // z
+	{KEY_7               , MOD_ALT_RIGHT                }, // {
+	{KEY_NON_US_BACKSLASH, MOD_ALT_RIGHT                }, // |
+	{KEY_0               , MOD_ALT_RIGHT                }, // }
+	{KEY_RIGHT_BRACKET   , MOD_ALT_RIGHT                }  // ~
+};  // }}}
+
+#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_FR
+// From layouts/fr.txt
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 1
+
+// Chars from ' ' to '~'
+static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
+	{KEY_SPACE           , 0                            }, // SPACE
+	{KEY_SLASH           , 0                            }, // !
+	{KEY_3               , 0                            }, // "
+	{KEY_3               , MOD_ALT_RIGHT                }, // #
+	{KEY_RIGHT_BRACKET   , 0                            }, // $
+	{KEY_APOSTROPHE      , MOD_SHIFT_LEFT               }, // %
+	{KEY_1               , 0                            }, // &
+	{KEY_4               , 0                            }, // '
+	{KEY_5               , 0                            }, // (
+	{KEY_MINUS           , 0                            }, // )
+	{KEY_NON_US_HASH     , 0                            }, // *
+	{KEY_EQUAL           , MOD_SHIFT_LEFT               }, // +
+	{KEY_M               , 0                            }, // ,
+	{KEY_6               , 0                            }, // -
+	{KEY_COMMA           , MOD_SHIFT_LEFT               }, // .
+	{KEY_PERIOD          , MOD_SHIFT_LEFT               }, // /
+	{KEY_0               , MOD_SHIFT_LEFT               }, // 0
+	{KEY_1               , MOD_SHIFT_LEFT               }, // 1
+	{KEY_2               , MOD_SHIFT_LEFT               }, // 2
+	{KEY_3               , MOD_SHIFT_LEFT               }, // 3
+	{KEY_4               , MOD_SHIFT_LEFT               }, // 4
+	{KEY_5               , MOD_SHIFT_LEFT               }, // 5
+	{KEY_6               , MOD_SHIFT_LEFT               }, // 6
+	{KEY_7               , MOD_SHIFT_LEFT               }, // 7
+	{KEY_8               , MOD_SHIFT_LEFT               }, // 8
+	{KEY_9               , MOD_SHIFT_LEFT               }, // 9
+	{KEY_PERIOD          , 0                            }, // :
+	{KEY_COMMA           , 0                            }, // ;
+	{KEY_NON_US_BACKSLASH, 0                            }, // <
+	{KEY_EQUAL           , 0                            }, // =
+	{KEY_NON_US_BACKSLASH, MOD_SHIFT_LEFT               }, // >
+	{KEY_M               , MOD_SHIFT_LEFT               }, // ?
+	{KEY_0               , MOD_ALT_RIGHT                }, // @
+	{KEY_Q               , MOD_SHIFT_LEFT               }, // A
+	{KEY_B               , MOD_SHIFT_LEFT               }, // B
+	{KEY_C               , MOD_SHIFT_LEFT               }, // C
+	{KEY_D               , MOD_SHIFT_LEFT               }, // D
+	{KEY_E               , MOD_SHIFT_LEFT               }, // E
+	{KEY_F               , MOD_SHIFT_LEFT               }, // F
+	{KEY_G               , MOD_SHIFT_LEFT               }, // G
+	{KEY_H               , MOD_SHIFT_LEFT               }, // H
+	{KEY_I               , MOD_SHIFT_LEFT               }, // I
+	{KEY_J               , MOD_SHIFT_LEFT               }, // J
+	{KEY_K               , MOD_SHIFT_LEFT               }, // K
+	{KEY_L               , MOD_SHIFT_LEFT               }, // L
+	{KEY_SEMICOLON       , MOD_SHIFT_LEFT               }, // M
+	{KEY_N               , MOD_SHIFT_LEFT               }, // N
+	{KEY_O               , MOD_SHIFT_LEFT               }, // O
+	{KEY_P               , MOD_SHIFT_LEFT               }, // P
+	{KEY_A               , MOD_SHIFT_LEFT               }, // Q
+	{KEY_R               , MOD_SHIFT_LEFT               }, // R
+	{KEY_S               , MOD_SHIFT_LEFT               }, // S
+	{KEY_T               , MOD_SHIFT_LEFT               }, // T
+	{KEY_U               , MOD_SHIFT_LEFT               }, // U
+	{KEY_V               , MOD_SHIFT_LEFT               }, // V
+	{KEY_Z               , MOD_SHIFT_LEFT               }, // W
+	{KEY_X               , MOD_SHIFT_LEFT               }, // X
+	{KEY_Y               , MOD_SHIFT_LEFT               }, // Y
+	{KEY_W               , MOD_SHIFT_LEFT               }, // Z
+	{KEY_5               , MOD_ALT_RIGHT                }, // [
+	{KEY_8               , MOD_ALT_RIGHT                }, // BACKSLASH
+	{KEY_MINUS           , MOD_ALT_RIGHT                }, // ]
+	{KEY_LEFT_BRACKET    , MOD_DEAD_KEY                 }, // ^
+	{KEY_8               , 0                            }, // _
+	{KEY_7               , MOD_ALT_RIGHT                }, // `
+	{KEY_Q               , 0                            }, // a
+	{KEY_B               , 0                            }, // b
+	{KEY_C               , 0                            }, // c
+	{KEY_D               , 0                            }, // d
+	{KEY_E               , 0                            }, // e
+	{KEY_F               , 0                            }, // f
+	{KEY_G               , 0                            }, // g
+	{KEY_H               , 0                            }, // h
+	{KEY_I               , 0                            }, // i
+	{KEY_J               , 0                            }, // j
+	{KEY_K               , 0                            }, // k
+	{KEY_L               , 0                            }, // l
+	{KEY_SEMICOLON       , 0                            }, // m
+	{KEY_N               , 0                            }, // n
+	{KEY_O               , 0                            }, // o
+	{KEY_P               , 0                            }, // p
+	{KEY_A               , 0                            }, // q
+	{KEY_R               , 0                            }, // r
+	{KEY_S               , 0                            }, // s
+	{KEY_T               , 0                            }, // t
+	{KEY_U               , 0                            }, // u
+	{KEY_V               , 0                            }, // v
+	{KEY_Z               , 0                            }, // w
+	{KEY_X               , 0                            }, // x
+	{KEY_Y               , 0                            }, // y
+	{KEY_W               , 0                            }, // z
+	{KEY_4               , MOD_ALT_RIGHT                }, // {
+	{KEY_6               , MOD_ALT_RIGHT                }, // |
+	{KEY_EQUAL           , MOD_ALT_RIGHT                }, // }
+	{KEY_2               , MOD_ALT_RIGHT                }  // ~
+};  // }}}
+
+#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_UK
+// From layouts/uk.txt
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 0
+
+// Chars from ' ' to '~'
+static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
+	{KEY_SPACE           , 0                            }, // SPACE
+	{KEY_1               , MOD_SHIFT_LEFT               }, // !
+	{KEY_2               , MOD_SHIFT_LEFT               }, // "
+	{KEY_NON_US_HASH     , 0                            }, // #
+	{KEY_4               , MOD_SHIFT_LEFT               }, // $
+	{KEY_5               , MOD_SHIFT_LEFT               }, // %
+	{KEY_7               , MOD_SHIFT_LEFT               }, // &
+	{KEY_APOSTROPHE      , 0                            }, // '
+	{KEY_9               , MOD_SHIFT_LEFT               }, // (
+	{KEY_0               , MOD_SHIFT_LEFT               }, // )
+	{KEY_8               , MOD_SHIFT_LEFT               }, // *
+	{KEY_EQUAL           , MOD_SHIFT_LEFT               }, // +
+	{KEY_COMMA           , 0                            }, // ,
+	{KEY_MINUS           , 0                            }, // -
+	{KEY_PERIOD          , 0                            }, // .
+	{KEY_SLASH           , 0                            }, // /
+	{KEY_0               , 0                            }, // 0
+	{KEY_1               , 0                            }, // 1
+	{KEY_2               , 0                            }, // 2
+	{KEY_3               , 0                            }, // 3
+	{KEY_4               , 0                            }, // 4
+	{KEY_5               , 0                            }, // 5
+	{KEY_6               , 0                            }, // 6
+	{KEY_7               , 0                            }, // 7
+	{KEY_8               , 0                            }, // 8
+	{KEY_9               , 0                            }, // 9
+	{KEY_SEMICOLON       , MOD_SHIFT_LEFT               }, // :
+	{KEY_SEMICOLON       , 0                            }, // ;
+	{KEY_COMMA           , MOD_SHIFT_LEFT               }, // <
+	{KEY_EQUAL           , 0                            }, // =
+	{KEY_PERIOD          , MOD_SHIFT_LEFT               }, // >
+	{KEY_SLASH           , MOD_SHIFT_LEFT               }, // ?
+	{KEY_APOSTROPHE      , MOD_SHIFT_LEFT               }, // @
+	{KEY_A               , MOD_SHIFT_LEFT               }, // A
+	{KEY_B               , MOD_SHIFT_LEFT               }, // B
+	{KEY_C               , MOD_SHIFT_LEFT               }, // C
+	{KEY_D               , MOD_SHIFT_LEFT               }, // D
+	{KEY_E               , MOD_SHIFT_LEFT               }, // E
+	{KEY_F               , MOD_SHIFT_LEFT               }, // F
+	{KEY_G               , MOD_SHIFT_LEFT               }, // G
+	{KEY_H               , MOD_SHIFT_LEFT               }, // H
+	{KEY_I               , MOD_SHIFT_LEFT               }, // I
+	{KEY_J               , MOD_SHIFT_LEFT               }, // J
+	{KEY_K               , MOD_SHIFT_LEFT               }, // K
+	{KEY_L               , MOD_SHIFT_LEFT               }, // L
+	{KEY_M               , MOD_SHIFT_LEFT               }, // M
+	{KEY_N               , MOD_SHIFT_LEFT               }, // N
+	{KEY_O               , MOD_SHIFT_LEFT               }, // O
+	{KEY_P               , MOD_SHIFT_LEFT               }, // P
+	{KEY_Q               , MOD_SHIFT_LEFT               }, // Q
+	{KEY_R               , MOD_SHIFT_LEFT               }, // R
+	{KEY_S               , MOD_SHIFT_LEFT               }, // S
+	{KEY_T               , MOD_SHIFT_LEFT               }, // T
+	{KEY_U               , MOD_SHIFT_LEFT               }, // U
+	{KEY_V               , MOD_SHIFT_LEFT               }, // V
+	{KEY_W               , MOD_SHIFT_LEFT               }, // W
+	{KEY_X               , MOD_SHIFT_LEFT               }, // X
+	{KEY_Y               , MOD_SHIFT_LEFT               }, // Y
+	{KEY_Z               , MOD_SHIFT_LEFT               }, // Z
+	{KEY_LEFT_BRACKET    , 0                            }, // [
+	{KEY_NON_US_BACKSLASH, 0                            }, // BACKSLASH
+	{KEY_RIGHT_BRACKET   , 0                            }, // ]
+	{KEY_6               , MOD_SHIFT_LEFT               }, // ^
+	{KEY_MINUS           , MOD_SHIFT_LEFT               }, // _
+	{KEY_GRAVE           , 0                            }, // `
+	{KEY_A               , 0                            }, // a
+	{KEY_B               , 0                            }, // b
+	{KEY_C               , 0                            }, // c
+	{KEY_D               , 0                            }, // d
+	{KEY_E               , 0                            }, // e
+	{KEY_F               , 0                            }, // f
+	{KEY_G               , 0                            }, // g
+	{KEY_H               , 0                            }, // h
+	{KEY_I               , 0                            }, // i
+	{KEY_J               , 0                            }, // j
+	{KEY_K               , 0                            }, // k
+	{KEY_L               , 0                            }, // l
+	{KEY_M               , 0                            }, // m
+	{KEY_N               , 0                            }, // n
+	{KEY_O               , 0                            }, // o
+	{KEY_P               , 0                            }, // p
+	{KEY_Q               , 0                            }, // q
+	{KEY_R               , 0                            }, // r
+	{KEY_S               , 0                            }, // s
+	{KEY_T               , 0                            }, // t
+	{KEY_U               , 0                            }, // u
+	{KEY_V               , 0                            }, // v
+	{KEY_W               , 0                            }, // w
+	{KEY_X               , 0                            }, // x
+	{KEY_Y               , 0                            }, // y
+	{KEY_Z               , 0                            }, // z
+	{KEY_LEFT_BRACKET    , MOD_SHIFT_LEFT               }, // {
+	{KEY_NON_US_BACKSLASH, MOD_SHIFT_LEFT               }, // |
+	{KEY_RIGHT_BRACKET   , MOD_SHIFT_LEFT               }, // }
+	{KEY_NON_US_HASH     , MOD_SHIFT_LEFT               }  // ~
+};  // }}}
+
+#elif KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_US
+// From layouts/us.txt
+#define KEYBOARD_LAYOUT_HAS_DEAD_KEYS 0
+
+// Chars from ' ' to '~'
+static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
+	{KEY_SPACE           , 0                            }, // SPACE
+	{KEY_1               , MOD_SHIFT_LEFT               }, // !
+	{KEY_APOSTROPHE      , MOD_SHIFT_LEFT               }, // "
+	{KEY_3               , MOD_SHIFT_LEFT               }, // #
+	{KEY_4               , MOD_SHIFT_LEFT               }, // $
+	{KEY_5               , MOD_SHIFT_LEFT               }, // %
+	{KEY_7               , MOD_SHIFT_LEFT               }, // &
+	{KEY_APOSTROPHE      , 0                            }, // '
+	{KEY_9               , MOD_SHIFT_LEFT               }, // (
+	{KEY_0               , MOD_SHIFT_LEFT               }, // )
+	{KEY_8               , MOD_SHIFT_LEFT               }, // *
+	{KEY_EQUAL           , MOD_SHIFT_LEFT               }, // +
+	{KEY_COMMA           , 0                            }, // ,
+	{KEY_MINUS           , 0                            }, // -
+	{KEY_PERIOD          , 0                            }, // .
+	{KEY_SLASH           , 0                            }, // /
+	{KEY_0               , 0                            }, // 0
+	{KEY_1               , 0                            }, // 1
+	{KEY_2               , 0                            }, // 2
+	{KEY_3               , 0                            }, // 3
+	{KEY_4               , 0                            }, // 4
+	{KEY_5               , 0                            }, // 5
+	{KEY_6               , 0                            }, // 6
+	{KEY_7               , 0                            }, // 7
+	{KEY_8               , 0                            }, // 8
+	{KEY_9               , 0                            }, // 9
+	{KEY_SEMICOLON       , MOD_SHIFT_LEFT               }, // :
+	{KEY_SEMICOLON       , 0                            }, // ;
+	{KEY_COMMA           , MOD_SHIFT_LEFT               }, // <
+	{KEY_EQUAL           , 0                            }, // =
+	{KEY_PERIOD          , MOD_SHIFT_LEFT               }, // >
+	{KEY_SLASH           , MOD_SHIFT_LEFT               }, // ?
+	{KEY_2               , MOD_SHIFT_LEFT               }, // @
+	{KEY_A               , MOD_SHIFT_LEFT               }, // A
+	{KEY_B               , MOD_SHIFT_LEFT               }, // B
+	{KEY_C               , MOD_SHIFT_LEFT               }, // C
+	{KEY_D               , MOD_SHIFT_LEFT               }, // D
+	{KEY_E               , MOD_SHIFT_LEFT               }, // E
+	{KEY_F               , MOD_SHIFT_LEFT               }, // F
+	{KEY_G               , MOD_SHIFT_LEFT               }, // G
+	{KEY_H               , MOD_SHIFT_LEFT               }, // H
+	{KEY_I               , MOD_SHIFT_LEFT               }, // I
+	{KEY_J               , MOD_SHIFT_LEFT               }, // J
+	{KEY_K               , MOD_SHIFT_LEFT               }, // K
+	{KEY_L               , MOD_SHIFT_LEFT               }, // L
+	{KEY_M               , MOD_SHIFT_LEFT               }, // M
+	{KEY_N               , MOD_SHIFT_LEFT               }, // N
+	{KEY_O               , MOD_SHIFT_LEFT               }, // O
+	{KEY_P               , MOD_SHIFT_LEFT               }, // P
+	{KEY_Q               , MOD_SHIFT_LEFT               }, // Q
+	{KEY_R               , MOD_SHIFT_LEFT               }, // R
+	{KEY_S               , MOD_SHIFT_LEFT               }, // S
+	{KEY_T               , MOD_SHIFT_LEFT               }, // T
+	{KEY_U               , MOD_SHIFT_LEFT               }, // U
+	{KEY_V               , MOD_SHIFT_LEFT               }, // V
+	{KEY_W               , MOD_SHIFT_LEFT               }, // W
+	{KEY_X               , MOD_SHIFT_LEFT               }, // X
+	{KEY_Y               , MOD_SHIFT_LEFT               }, // Y
+	{KEY_Z               , MOD_SHIFT_LEFT               }, // Z
+	{KEY_LEFT_BRACKET    , 0                            }, // [
+	{KEY_BACKSLASH       , 0                            }, // BACKSLASH
+	{KEY_RIGHT_BRACKET   , 0                            }, // ]
+	{KEY_6               , MOD_SHIFT_LEFT               }, // ^
+	{KEY_MINUS           , MOD_SHIFT_LEFT               }, // _
+	{KEY_GRAVE           , 0                            }, // `
+	{KEY_A               , 0                            }, // a
+	{KEY_B               , 0                            }, // b
+	{KEY_C               , 0                            }, // c
+	{KEY_D               , 0                            }, // d
+	{KEY_E               , 0                            }, // e
+	{KEY_F               , 0                            }, // f
+	{KEY_G               , 0                            }, // g
+	{KEY_H               , 0                            }, // h
+	{KEY_I               , 0                            }, // i
+	{KEY_J               , 0                            }, // j
+	{KEY_K               , 0                            }, // k
+	{KEY_L               , 0                            }, // l
+	{KEY_M               , 0                            }, // m
+	{KEY_N               , 0                            }, // n
+	{KEY_O               , 0                            }, // o
+	{KEY_P               , 0                            }, // p
+	{KEY_Q               , 0                            }, // q
+	{KEY_R               , 0                            }, // r
+	{KEY_S               , 0                            }, // s
+	{KEY_T               , 0                            }, // t
+	{KEY_U               , 0                            }, // u
+	{KEY_V               , 0                            }, // v
+	{KEY_W               , 0                            }, // w
+	{KEY_X               , 0                            }, // x
+	{KEY_Y               , 0                            }, // y
+	{KEY_Z               , 0                            }, // z
+	{KEY_LEFT_BRACKET    , MOD_SHIFT_LEFT               }, // {
+	{KEY_BACKSLASH       , MOD_SHIFT_LEFT               }, // |
+	{KEY_RIGHT_BRACKET   , MOD_SHIFT_LEFT               }, // }
+	{KEY_GRAVE           , MOD_SHIFT_LEFT               }  // ~
+};  // }}}
+
+#else
+#error "Unknown KEYBOARD_LAYOUT, see the layouts directory"
+#endif
+
+
+#endif  // __keyboard_layouts_h_included____
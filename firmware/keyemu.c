@@ -21,11 +21,19 @@
 // HID report
 KeyboardReport keyboard_report;
 
+#if ENABLE_OUTPUT_QUEUE
+// Segments of text being typed.
+OutputQueue output_queue;
+#else
 // Pointer to RAM for the string being typed.
 uchar *string_output_pointer = NULL;
+#endif
 
+#if !ENABLE_RAM_OVERLAY
 // Shared output buffer, other functions are free to use this as needed.
+// With ENABLE_RAM_OVERLAY, it lives at mode_overlay (overlay.h).
 uchar string_output_buffer[STRING_OUTPUT_BUFFER_SIZE];
+#endif
 
 
 // Keyboard usage values  {{{
@@ -41,63 +49,76 @@ uchar string_output_buffer[STRING_OUTPUT_BUFFER_SIZE];
 #define MOD_ALT_RIGHT       (1<<6)
 #define MOD_GUI_RIGHT       (1<<7)
 
-#define KEY_A          4
-#define KEY_B          5
-#define KEY_C          6
-#define KEY_D          7
-#define KEY_E          8
-#define KEY_F          9
-#define KEY_G          10
-#define KEY_H          11
-#define KEY_I          12
-#define KEY_J          13
-#define KEY_K          14
-#define KEY_L          15
-#define KEY_M          16
-#define KEY_N          17
-#define KEY_O          18
-#define KEY_P          19
-#define KEY_Q          20
-#define KEY_R          21
-#define KEY_S          22
-#define KEY_T          23
-#define KEY_U          24
-#define KEY_V          25
-#define KEY_W          26
-#define KEY_X          27
-#define KEY_Y          28
-#define KEY_Z          29
-#define KEY_1          30
-#define KEY_2          31
-#define KEY_3          32
-#define KEY_4          33
-#define KEY_5          34
-#define KEY_6          35
-#define KEY_7          36
-#define KEY_8          37
-#define KEY_9          38
-#define KEY_0          39
-#define KEY_ENTER      40
-#define KEY_ESCAPE     41
-#define KEY_TAB        43
-#define KEY_SPACE      44
-#define KEY_MINUS      45
-#define KEY_EQUAL      46
-#define KEY_SEMICOLON  51
-#define KEY_COMMA      54
-#define KEY_PERIOD     55
-#define KEY_F1         58
-#define KEY_F2         59
-#define KEY_F3         60
-#define KEY_F4         61
-#define KEY_F5         62
-#define KEY_F6         63
-#define KEY_F7         64
-#define KEY_F8         65
-#define KEY_F9         66
-#define KEY_F10        67
-#define KEY_F11        68
-#define KEY_F12        69
+// The GUI key is never needed to type a char, so its bit marks the dead keys
+// in char_to_key[] (see send_next_char()), and is never sent to the host.
+#define MOD_DEAD_KEY        MOD_GUI_RIGHT
+
+#define KEY_A                4
+#define KEY_B                5
+#define KEY_C                6
+#define KEY_D                7
+#define KEY_E                8
+#define KEY_F                9
+#define KEY_G                10
+#define KEY_H                11
+#define KEY_I                12
+#define KEY_J                13
+#define KEY_K                14
+#define KEY_L                15
+#define KEY_M                16
+#define KEY_N                17
+#define KEY_O                18
+#define KEY_P                19
+#define KEY_Q                20
+#define KEY_R                21
+#define KEY_S                22
+#define KEY_T                23
+#define KEY_U                24
+#define KEY_V                25
+#define KEY_W                26
+#define KEY_X                27
+#define KEY_Y                28
+#define KEY_Z                29
+#define KEY_1                30
+#define KEY_2                31
+#define KEY_3                32
+#define KEY_4                33
+#define KEY_5                34
+#define KEY_6                35
+#define KEY_7                36
+#define KEY_8                37
+#define KEY_9                38
+#define KEY_0                39
+#define KEY_ENTER            40
+#define KEY_ESCAPE           41
+#define KEY_TAB              43
+#define KEY_SPACE            44
+#define KEY_MINUS            45
+#define KEY_EQUAL            46
+#define KEY_LEFT_BRACKET     47
+#define KEY_RIGHT_BRACKET    48
+#define KEY_BACKSLASH        49
+#define KEY_NON_US_HASH      50
+#define KEY_SEMICOLON        51
+#define KEY_APOSTROPHE       52
+#define KEY_GRAVE            53
+#define KEY_COMMA            54
+#define KEY_PERIOD           55
+#define KEY_SLASH            56
+#define KEY_F1               58
+#define KEY_F2               59
+#define KEY_F3               60
+#define KEY_F4               61
+#define KEY_F5               62
+#define KEY_F6               63
+#define KEY_F7               64
+#define KEY_F8               65
+#define KEY_F9               66
+#define KEY_F10              67
+#define KEY_F11              68
+#define KEY_F12              69
+#define KEY_NON_US_BACKSLASH 100
+#define KEY_INTERNATIONAL1   135
 
 // }}}
 
@@ -110,6 +131,10 @@ typedef struct KeyAndModifier {
 } KeyAndModifier;
 
 
+// Tables generated from layouts/*.txt, selected by KEYBOARD_LAYOUT
+#include "keyboard_layouts.h"
+
+#if KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_BUILTIN
 // Warning: ';:' key is c-cedilla in BR-ABNT2 layout
 // Warning: '/?' key is ';:' in BR-ABNT2 layout
 // Other characters not in this lookup table:
@@ -149,6 +174,12 @@ static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
 	{0            , 0             }, // ?
 	{KEY_2        , MOD_SHIFT_LEFT}  // @
 };  // }}}
+#endif
+
+#if KEYBOARD_LAYOUT_HAS_DEAD_KEYS
+// Nonzero after typing a dead key, which must be followed by a space
+static uchar dead_key_typed;
+#endif
 
 // }}}
 
@@ -156,11 +187,12 @@ static const KeyAndModifier char_to_key[] PROGMEM = {  // {{{
 void init_keyboard_emulation() {  // {{{
 	// According to avr-libc FAQ, the compiler automatically initializes
 	// all variables with zero.
-	keyboard_report.report_id = 1;
+	keyboard_report.report_id = KEYBOARD_REPORT_ID;
 	//keyboard_report.modifier = 0;
 	//keyboard_report.key = 0;
 }  // }}}
 
+#if KEYBOARD_LAYOUT == KEYBOARD_LAYOUT_BUILTIN
 void build_report_from_char(uchar c) {  // {{{
 	// Using a local pointer saves around 6 bytes
 	KeyboardReport *repptr = &keyboard_report;
@@ -199,10 +231,221 @@ void build_report_from_char(uchar c) {  // {{{
 		}
 	}
 }  // }}}
+#else
+void build_report_from_char(uchar c) {  // {{{
+	// The generated char_to_key[] has all printable chars.
+	// With MOD_DEAD_KEY, the modifier must be fixed by the caller.
+
+	// Using a local pointer saves around 6 bytes
+	KeyboardReport *repptr = &keyboard_report;
+	FIX_POINTER(repptr);
+
+	// For most cases, modifier is zero
+	repptr->modifier = 0;
+
+	if (c >= ' ' && c <= '~') {
+		repptr->modifier = pgm_read_byte_near(&char_to_key[c - ' '].modifier);
+		repptr->key = pgm_read_byte_near(&char_to_key[c - ' '].key);
+	} else if (c == '\n') {
+		repptr->key = KEY_ENTER;
+	} else if (c == '\t') {
+		repptr->key = KEY_TAB;
+	} else {
+		repptr->key = 0;
+	}
+}  // }}}
+#endif
+
+
+#if ENABLE_PACKED_STRINGS
+static const uchar* packed_strings_lookup(uchar code) {  // {{{
+	// Returns the dictionary entry of a code (0x80 to 0xFF).
+	// The entries are stored one after the other, each one ending with
+	// '\0', so the previous ones are skipped. It is slow, but the typing is
+	// much slower.
+
+	const uchar *entry = packed_strings_dictionary;
+
+	code -= PACKED_STRINGS_FIRST_CODE;
+	while (code--) {
+		while (pgm_read_byte(entry++) != '\0') {
+		}
+	}
+	return entry;
+}  // }}}
+
+#if !ENABLE_OUTPUT_QUEUE
+void packed_strings_unpack(uchar *dst, const uchar *src) {  // {{{
+	// Like strcpy_P(), but expands the dictionary codes.
+
+	uchar c;
+
+	do {
+		c = pgm_read_byte(src++);
+		if (c >= PACKED_STRINGS_FIRST_CODE) {
+			const uchar *entry = packed_strings_lookup(c);
+			while ((c = pgm_read_byte(entry++)) != '\0') {
+				*dst++ = c;
+			}
+			// Not the end of the string
+			c = 1;
+		} else {
+			*dst++ = c;
+		}
+	} while (c != '\0');
+}  // }}}
+#endif
+#endif
+
+
+#if ENABLE_OUTPUT_QUEUE
+static void output_enqueue(uchar type, const uchar *ptr, uchar suffix) {  // {{{
+	// For numbers, "ptr" is actually the absolute value.
+
+	OutputQueue *out = &output_queue;
+	FIX_POINTER(out);
+
+	OutputSegment *seg;
+
+	if (out->count == OUTPUT_QUEUE_SIZE) {
+		return;
+	}
+
+	seg = &out->segments[out->count];
+	seg->type = type;
+	seg->suffix = suffix;
+	seg->ptr = ptr;
+	seg->divisor = 0;
+
+	if (type >= OUTPUT_NEGATIVE) {
+		// Finding the weight of the first digit, so that there are no
+		// leading zeros.
+		seg->divisor = 1;
+		while (seg->divisor <= seg->value / 10) {
+			seg->divisor *= 10;
+		}
+	}
+
+	out->count++;
+}  // }}}
+
+void output_pgm_string(PGM_P str) {  // {{{
+	output_enqueue(OUTPUT_PGM, (const uchar*) str, '\0');
+}  // }}}
+
+void output_ram_string(const uchar *str) {  // {{{
+	output_enqueue(OUTPUT_RAM, str, '\0');
+}  // }}}
+
+void output_int(int v, uchar suffix) {  // {{{
+	// Types the number in decimal, followed by the suffix char.
+	if (v < 0) {
+		output_enqueue(OUTPUT_NEGATIVE, (const uchar*) -(unsigned int) v, suffix);
+	} else {
+		output_enqueue(OUTPUT_NUMBER, (const uchar*) (unsigned int) v, suffix);
+	}
+}  // }}}
+
+void output_xyz_vector(XYZVector *vector) {  // {{{
+	// "-1234\t1234\t-1234\n", same as XYZVector_to_string()
+	output_int(vector->x, '\t');
+	output_int(vector->y, '\t');
+	output_int(vector->z, '\n');
+}  // }}}
+
+static uchar output_peek_char() {  // {{{
+	// Returns the next char to be typed, without consuming it.
+	// Returns '\0' (and empties the queue) if there is nothing left.
+
+	OutputQueue *out = &output_queue;
+	FIX_POINTER(out);
+
+	while (out->head < out->count) {
+		OutputSegment *seg = &out->segments[out->head];
+		uchar c;
+
+		switch (seg->type) {
+			case OUTPUT_RAM:
+				c = *seg->ptr;
+				break;
+			case OUTPUT_PGM:
+#if ENABLE_PACKED_STRINGS
+				if (seg->expansion) {
+					c = pgm_read_byte(seg->expansion);
+					if (c != '\0') {
+						break;
+					}
+					// End of the dictionary entry
+					seg->expansion = NULL;
+					seg->ptr++;
+				}
+				c = pgm_read_byte(seg->ptr);
+				if (c >= PACKED_STRINGS_FIRST_CODE) {
+					seg->expansion = packed_strings_lookup(c);
+					c = pgm_read_byte(seg->expansion);
+				}
+#else
+				c = pgm_read_byte(seg->ptr);
+#endif
+				break;
+			case OUTPUT_NEGATIVE:
+				c = '-';
+				break;
+			default:  // OUTPUT_NUMBER
+				if (seg->divisor) {
+					c = '0' + seg->value / seg->divisor;
+				} else {
+					c = seg->suffix;
+				}
+		}
+
+		if (c != '\0') {
+			return c;
+		}
+
+		// This segment is over
+		out->head++;
+	}
+
+	out->head = 0;
+	out->count = 0;
+	return '\0';
+}  // }}}
+
+static void output_consume_char() {  // {{{
+	// Must be called only after output_peek_char() has returned a char.
+
+	OutputSegment *seg = &output_queue.segments[output_queue.head];
+
+	switch (seg->type) {
+		case OUTPUT_PGM:
+#if ENABLE_PACKED_STRINGS
+			if (seg->expansion) {
+				seg->expansion++;
+				break;
+			}
+#endif
+		case OUTPUT_RAM:
+			seg->ptr++;
+			break;
+		case OUTPUT_NEGATIVE:
+			seg->type = OUTPUT_NUMBER;
+			break;
+		default:  // OUTPUT_NUMBER
+			if (seg->divisor) {
+				seg->value %= seg->divisor;
+				seg->divisor /= 10;
+			} else {
+				seg->suffix = '\0';
+			}
+	}
+}  // }}}
+#endif
 
 
 uchar send_next_char() {  // {{{
-	// Builds a Report with the char pointed by 'string_output_pointer'.
+	// Builds a Report with the char pointed by 'string_output_pointer'
+	// (or with the next char from the output queue).
 	//
 	// If a valid char is found, builds the report and returns 1.
 	// If the pointer is NULL or the char is '\0', builds a "no key being
@@ -216,11 +459,31 @@ uchar send_next_char() {  // {{{
 	KeyboardReport *repptr = &keyboard_report;
 	FIX_POINTER(repptr);
 
+#if KEYBOARD_LAYOUT_HAS_DEAD_KEYS
+	if (dead_key_typed) {
+		// A dead key only types its own char when followed by a space
+		dead_key_typed = 0;
+		repptr->modifier = 0;
+		repptr->key = KEY_SPACE;
+		return 1;
+	}
+#endif
+
+#if ENABLE_OUTPUT_QUEUE
+	uchar c = output_peek_char();
+
+	if (c != '\0') {
+#else
 	if (string_output_pointer != NULL && *string_output_pointer != '\0') {
+#endif
 		uchar old_key;
 
 		old_key = repptr->key;
+#if ENABLE_OUTPUT_QUEUE
+		build_report_from_char(c);
+#else
 		build_report_from_char(*string_output_pointer);
+#endif
 
 		if (old_key == repptr->key && repptr->key != 0) {
 			// Inserting a key release if the next key would be the same as
@@ -228,14 +491,24 @@ uchar send_next_char() {  // {{{
 			repptr->modifier = 0;
 			repptr->key = 0;
 		} else {
+#if KEYBOARD_LAYOUT_HAS_DEAD_KEYS
+			dead_key_typed = repptr->modifier & MOD_DEAD_KEY;
+			repptr->modifier &= ~MOD_DEAD_KEY;
+#endif
+#if ENABLE_OUTPUT_QUEUE
+			output_consume_char();
+#else
 			string_output_pointer++;
+#endif
 		}
 
 		return 1;
 	} else {
 		repptr->modifier = 0;
 		repptr->key = 0;
+#if !ENABLE_OUTPUT_QUEUE
 		string_output_pointer = NULL;
+#endif
 		return 0;
 	}
 }  // }}}
@@ -267,6 +540,46 @@ void int_to_hex(int v, uchar *str) {  // {{{
 	uchar_to_hex((uchar) v      , str+2);
 }  // }}}
 
+#if ENABLE_COMPACT_XYZ
+static const unsigned int powers_of_ten[4] PROGMEM = {10000, 1000, 100, 10};
+
+uchar* int_to_dec(int v, uchar *str) {  // {{{
+	// Returns a pointer to the '\0' char
+	//
+	// Same output of itoa(), but each digit is found by subtracting its
+	// weight, at most 9 times. The AVR has no divide instruction, and
+	// itoa() calls the 16-bit division routine once per digit.
+
+	unsigned int u = v;
+	unsigned int weight;
+	uchar i;
+	uchar digit;
+	uchar started = 0;
+
+	if (v < 0) {
+		*str++ = '-';
+		u = -u;
+	}
+
+	for (i = 0; i < 4; i++) {
+		weight = pgm_read_word(&powers_of_ten[i]);
+		digit = '0';
+		while (u >= weight) {
+			u -= weight;
+			digit++;
+		}
+		// No leading zeros
+		if (started || digit != '0') {
+			*str++ = digit;
+			started = 1;
+		}
+	}
+	*str++ = '0' + u;
+	*str = '\0';
+
+	return str;
+}  // }}}
+#else
 uchar* int_to_dec(int v, uchar *str) {  // {{{
 	// Returns a pointer to the '\0' char
 
@@ -276,6 +589,7 @@ uchar* int_to_dec(int v, uchar *str) {  // {{{
 	}
 	return str;
 }  // }}}
+#endif
 
 uchar* append_newline_to_str(uchar *str) {  // {{{
 	// Returns a pointer to the '\0' char
@@ -332,5 +646,90 @@ uchar* XYZVector_to_string(XYZVector* vector, uchar *str) {  // {{{
 	return str;
 }  // }}}
 
+#if ENABLE_COMPACT_XYZ
+static uchar crc8_update(uchar crc, uchar data) {  // {{{
+	// CRC-8 with polynomial x^8 + x^2 + x + 1 (0x07), MSB first.
+	uchar i;
+
+	crc ^= data;
+	for (i = 0; i < 8; i++) {
+		if (crc & 0x80) {
+			crc = (crc << 1) ^ 0x07;
+		} else {
+			crc <<= 1;
+		}
+	}
+	return crc;
+}  // }}}
+
+static uchar base32_digit(uchar n) {  // {{{
+	// Crockford's base-32 alphabet, in lowercase:
+	// "0123456789abcdefghjkmnpqrstvwxyz"
+	// No shift key is needed, and the ambiguous i, l, o, u are skipped.
+	uchar c;
+
+	if (n < 10) {
+		return '0' + n;
+	}
+	c = 'a' - 10 + n;
+	if (c >= 'i') c++;
+	if (c >= 'l') c++;
+	if (c >= 'o') c++;
+	if (c >= 'u') c++;
+	return c;
+}  // }}}
+
+uchar* XYZVector_to_compact(XYZVector* vector, uchar seq, uchar *str) {  // {{{
+	// Builds "0123456789\n", 50 bits in 10 base-32 digits, most significant
+	// bits first:
+	//   x (13 bits), y (13 bits), z (13 bits), seq (3 bits), crc (8 bits)
+	// The axes are two's complement, from -4096 to 4095, which is the whole
+	// HMC5883L output (-4096 means overflow). The CRC covers the bytes
+	//   x & 0x1FFF (low, high), y (same), z (same), seq & 7
+	// See host_tools/xyz_decode.py.
+	//
+	// It is about 1/3 shorter than the XYZVector_to_string() line, and
+	// needs no division at all.
+	//
+	// Returns a pointer to the '\0' char
+
+	unsigned int values[5];
+	unsigned long bits = 0;
+	uchar total_bits = 0;
+	uchar crc = 0;
+	uchar i;
+
+	values[0] = vector->x & 0x1FFF;
+	values[1] = vector->y & 0x1FFF;
+	values[2] = vector->z & 0x1FFF;
+	values[3] = seq & 7;
+
+	for (i = 0; i < 3; i++) {
+		crc = crc8_update(crc, values[i]);
+		crc = crc8_update(crc, values[i] >> 8);
+	}
+	values[4] = crc8_update(crc, values[3]);
+
+	for (i = 0; i < 5; i++) {
+		uchar width = (i < 3) ? 13 : (i == 3) ? 3 : 8;
+
+		// At most 4 bits are left over from the previous value, so only
+		// the lowest 17 bits of "bits" matter.
+		bits = (bits << width) | values[i];
+		total_bits += width;
+
+		while (total_bits >= 5) {
+			total_bits -= 5;
+			*str++ = base32_digit((bits >> total_bits) & 0x1F);
+		}
+	}
+
+	*str++ = '\n';
+	*str = '\0';
+
+	return str;
+}  // }}}
+#endif
+
 
 // vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
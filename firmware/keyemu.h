@@ -8,6 +8,7 @@
 
 #include "common.h"
 #include "sensor.h"
+#include "hidreport.h"
 
 
 typedef struct KeyboardReport {
@@ -20,18 +21,152 @@ typedef struct KeyboardReport {
 extern KeyboardReport keyboard_report;
 
 
+// Strings typed by output_pgm_string() should be declared with
+// PACKED_STRING(name, "text"). With ENABLE_PACKED_STRINGS, they are
+// compressed at build time by pack_strings.py: a byte from 0x80 to 0xFF
+// stands for one entry of packed_strings_dictionary[] (plain ASCII is
+// kept as is, so any other PGM string can still be typed).
+// PACKED_OFFSET(name, offset) points to the middle of one of those strings.
+#if ENABLE_PACKED_STRINGS
+#if defined(PACKED_STRINGS_EXTRACT)
+// Preprocessor-only pass, run by the Makefile, see pack_strings.py
+#define PACKED_STRING(name, text)    PACKED_STRING_MARKER name text
+#define PACKED_OFFSET(name, offset)  PACKED_OFFSET_MARKER name offset
+#else
+// Already defined by packed_strings.h
+#define PACKED_STRING(name, text)
+#define PACKED_OFFSET(name, offset)  ((name) + name##_at_##offset)
+#endif
+
+#define PACKED_STRINGS_FIRST_CODE 0x80
+extern const uchar packed_strings_dictionary[];
+#else
+#define PACKED_STRING(name, text)    static const char name[] PROGMEM = text
+#define PACKED_OFFSET(name, offset)  ((name) + (offset))
+#endif
+
+
+#if ENABLE_COMPACT_XYZ
+// Compact X,Y,Z line: 10 base-32 digits and '\n', see XYZVector_to_compact()
+#define XYZ_COMPACT_LENGTH 12  // Including the '\0'
+
+// Types the compact line of a vector. "seq" is a line counter, only its
+// lowest 3 bits are used.
+#define output_xyz_compact(vector, seq) do { \
+		XYZVector_to_compact((vector), (seq), string_output_buffer); \
+		output_ram_string(string_output_buffer); \
+	} while(0)
+#endif
+
+
+#if ENABLE_OUTPUT_QUEUE
+
+#include <avr/pgmspace.h>
+
+// The text to be typed is a queue of segments, which are read one char at
+// a time, right before being typed. Strings are not copied anywhere, and
+// numbers are formatted on the fly.
+#define OUTPUT_QUEUE_SIZE 6
+
+// Values of OutputSegment.type
+#define OUTPUT_RAM       0  // "ptr" points to a string in RAM
+#define OUTPUT_PGM       1  // "ptr" points to a string in flash
+#define OUTPUT_NEGATIVE  2  // Like OUTPUT_NUMBER, but types '-' first
+#define OUTPUT_NUMBER    3  // Types "value", then "suffix"
+
+typedef struct OutputSegment {
+	uchar type;
+	uchar suffix;  // Only for numbers, '\0' if none or already typed
+	union {
+		const uchar *ptr;
+		unsigned int value;  // Absolute value, without the digits typed so far
+	};
+	union {
+		unsigned int divisor;  // Weight of the next digit, 0 after the last one
+		const uchar *expansion;  // ENABLE_PACKED_STRINGS: dictionary entry being typed
+	};
+} OutputSegment;
+
+typedef struct OutputQueue {
+	OutputSegment segments[OUTPUT_QUEUE_SIZE];
+	uchar head;   // Segment being typed
+	uchar count;  // Zero when there is nothing left to type
+} OutputQueue;
+
+extern OutputQueue output_queue;
+
+// Nonzero while something is being typed
+#define output_busy() (output_queue.count != 0)
+
+// These only queue the output. If the queue is full, the text is dropped.
+// The strings must stay unchanged until typed. Numbers (including the
+// XYZVector components) are copied into the queue.
+void output_pgm_string(PGM_P str);
+void output_ram_string(const uchar *str);
+void output_int(int v, uchar suffix);
+void output_xyz_vector(XYZVector *vector);
+
+// Only used by sensor_read_identification_string() and output_xyz_compact()
+#if ENABLE_COMPACT_XYZ
+#define STRING_OUTPUT_BUFFER_SIZE XYZ_COMPACT_LENGTH
+#else
+#define STRING_OUTPUT_BUFFER_SIZE 8
+#endif
+#if !ENABLE_RAM_OVERLAY
+extern uchar string_output_buffer[STRING_OUTPUT_BUFFER_SIZE];
+#endif
+
+#else
+
 // Copies a string from PGM to string_output_buffer and also sets
 // string_output_pointer.
+#if ENABLE_PACKED_STRINGS
+#define output_pgm_string(str) do { \
+		packed_strings_unpack(string_output_buffer, (const uchar*) (str)); \
+		string_output_pointer = string_output_buffer; \
+	} while(0)
+#else
 #define output_pgm_string(str) do { \
 		strcpy_P(string_output_buffer, str); \
 		string_output_pointer = string_output_buffer; \
 	} while(0)
+#endif
+
+// Appends a string from PGM to the end of a string in RAM, like strcat_P()
+#if ENABLE_PACKED_STRINGS
+#define append_pgm_string(dst, str) \
+		packed_strings_unpack((uchar*) strchr((char*) (dst), '\0'), (const uchar*) (str))
+#else
+#define append_pgm_string(dst, str)  strcat_P((dst), (str))
+#endif
+
+// Types a string that is already in RAM
+#define output_ram_string(str) do { \
+		string_output_pointer = (str); \
+	} while(0)
+
+// Types "x\ty\tz\n"
+#define output_xyz_vector(vector) do { \
+		XYZVector_to_string((vector), string_output_buffer); \
+		string_output_pointer = string_output_buffer; \
+	} while(0)
+
+// Nonzero while something is being typed
+#define output_busy() (string_output_pointer != NULL)
 
 
 #define STRING_OUTPUT_BUFFER_SIZE 100
 extern uchar *string_output_pointer;
+#if !ENABLE_RAM_OVERLAY
 extern uchar string_output_buffer[STRING_OUTPUT_BUFFER_SIZE];
+#endif
+
+#endif
+
 
+#if ENABLE_PACKED_STRINGS
+void packed_strings_unpack(uchar *dst, const uchar *src);
+#endif
 
 void init_keyboard_emulation();
 void build_report_from_char(uchar c);
@@ -44,6 +179,9 @@ uchar* int_to_dec(int v, uchar *str);
 uchar* append_newline_to_str(uchar *str);
 uchar* array_to_hexdump(uchar *data, uchar len, uchar *str);
 uchar* XYZVector_to_string(XYZVector* vector, uchar *str);
+#if ENABLE_COMPACT_XYZ
+uchar* XYZVector_to_compact(XYZVector* vector, uchar seq, uchar *str);
+#endif
 
 
 #endif  // __keyemu_h_included____
@@ -25,6 +25,9 @@
 #include <avr/wdt.h>
 #include <util/delay.h>
 
+// ATmega8 register names on ATmega88/168/328
+#include "mcucompat.h"
+
 // V-USB driver from http://www.obdev.at/products/vusb/
 #include "usbdrv.h"
 
@@ -48,6 +51,45 @@
 // Button handling code
 #include "buttons.h"
 
+// Timer0-based ticker and timestamps
+#include "clock.h"
+
+#if ENABLE_POLL_SYNC
+// Synchronization of sensor readings with the USB host polling
+#include "pollsync.h"
+#endif
+
+#if ENABLE_SCHEDULER
+// Cooperative scheduler for the periodic tasks
+#include "scheduler.h"
+#endif
+
+// Cycle counting of the main loop (compiled out if not enabled)
+#include "profiling.h"
+
+#if ENABLE_IDLE_SLEEP
+// Sleeping between events
+#include "idlesleep.h"
+#endif
+
+// Startup timings (compiled out if not enabled)
+#include "diagnostics.h"
+
+#if ENABLE_STACK_MONITOR
+// Stack high-water mark
+#include "stackmon.h"
+#endif
+
+#if ENABLE_BUS_RECOVERY
+// I2C bus fault recovery
+#include "busrecovery.h"
+#endif
+
+#if ENABLE_CALIBRATION_STORE
+// Calibration profiles in the EEPROM
+#include "calstore.h"
+#endif
+
 
 #if ENABLE_KEYBOARD
 
@@ -67,6 +109,15 @@
 #endif
 
 
+#if ENABLE_REPORT_TIMESTAMPS && ENABLE_HOST_PROJECTION
+#error "ENABLE_REPORT_TIMESTAMPS only works with the mouse report, not with ENABLE_HOST_PROJECTION."
+#endif
+
+#if ENABLE_REPORT_TIMESTAMPS && ENABLE_DIGITIZER
+#error "ENABLE_REPORT_TIMESTAMPS only works with the mouse report, not with ENABLE_DIGITIZER."
+#endif
+
+
 ////////////////////////////////////////////////////////////
 // Hardware description                                  {{{
 
@@ -125,72 +176,47 @@
 ////////////////////////////////////////////////////////////
 // USB HID Report Descriptor                             {{{
 
-// If this HID report descriptor is changed, remember to update
-// USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH from usbconfig.h
-PROGMEM const char usbHidReportDescriptor[USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH]
+// The collections and reports are declared at hidreport.h, and
+// USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH is counted from them. The checks
+// below make sure this array and the report structs agree with them.
+PROGMEM const char usbHidReportDescriptor[]
 __attribute__((externally_visible))
 = {
-	// Keyboard
-	0x05, 0x01,              // USAGE_PAGE (Generic Desktop)
-	0x09, 0x06,              // USAGE (Keyboard)
-	0xa1, 0x01,              // COLLECTION (Application)
-	0x85, 0x01,              //   REPORT_ID (1)
-	// Modifier keys (they must come BEFORE the real keys)
-	0x05, 0x07,              //   USAGE_PAGE (Keyboard)
-	0x19, 0xe0,              //   USAGE_MINIMUM (Keyboard LeftControl)
-	0x29, 0xe7,              //   USAGE_MAXIMUM (Keyboard Right GUI)
-	0x15, 0x00,              //   LOGICAL_MINIMUM (0)
-	0x25, 0x01,              //   LOGICAL_MAXIMUM (1)
-	0x75, 0x01,              //   REPORT_SIZE (1)
-	0x95, 0x08,              //   REPORT_COUNT (8)
-	0x81, 0x02,              //   INPUT (Data,Var,Abs)
-	// Normal keys
-//	0x05, 0x07,              //   USAGE_PAGE (Keyboard)
-	0x19, 0x00,              //   USAGE_MINIMUM (Reserved (no event indicated))
-	0x29, 0x65,              //   USAGE_MAXIMUM (Keyboard Application)
-//	0x15, 0x00,              //   LOGICAL_MINIMUM (0)
-	0x25, 0x65,              //   LOGICAL_MAXIMUM (101)
-	0x75, 0x08,              //   REPORT_SIZE (8)
-	0x95, 0x01,              //   REPORT_COUNT (1)
-	0x81, 0x00,              //   INPUT (Data,Ary,Abs)
-	0xc0,                    // END_COLLECTION
-
-	// Mouse
-	0x05, 0x01,              // USAGE_PAGE (Generic Desktop)
-	0x09, 0x02,              // USAGE (Mouse)
-	0xa1, 0x01,              // COLLECTION (Application)
-	0x85, 0x02,              //   REPORT_ID (2)
-//	0x05, 0x01,              //   USAGE_PAGE (Generic Desktop)
-	0x09, 0x01,              //   USAGE (Pointer)
-	0xa1, 0x00,              //   COLLECTION (Physical)
-	// X, Y movement
-//	0x05, 0x01,              //     USAGE_PAGE (Generic Desktop)
-	0x09, 0x30,              //     USAGE (X)
-	0x09, 0x31,              //     USAGE (Y)
-//	0x15, 0x00,              //     LOGICAL_MINIMUM (0)
-	0x26, 0xff, 0x7f,        //     LOGICAL_MAXIMUM (32767)
-//	0x35, 0x00,              //     PHYSICAL_MINIMUM (0)
-//	0x46, 0xff, 0x7f,        //     PHYSICAL_MAXIMUM (32767)
-	0x75, 0x10,              //     REPORT_SIZE (16)
-	0x95, 0x02,              //     REPORT_COUNT (2)
-	0x81, 0x42,              //     INPUT (Data,Var,Abs,Null)
-	0xc0,                    //   END_COLLECTION
-	// Buttons
-	0x05, 0x09,              //   USAGE_PAGE (Button)
-	0x19, 0x01,              //   USAGE_MINIMUM (Button 1)
-	0x29, 0x03,              //   USAGE_MAXIMUM (Button 3)
-//	0x15, 0x00,              //   LOGICAL_MINIMUM (0)
-	0x25, 0x01,              //   LOGICAL_MAXIMUM (1)
-	0x75, 0x01,              //   REPORT_SIZE (1)
-	0x95, 0x03,              //   REPORT_COUNT (3)
-	0x81, 0x02,              //   INPUT (Data,Var,Abs)
-	// Padding for the buttons
-//	0x75, 0x01,              //   REPORT_SIZE (1)
-	0x95, 0x05,              //   REPORT_COUNT (5)
-	0x81, 0x03,              //   INPUT (Cnst,Var,Abs)
-	0xc0                     // END_COLLECTION
+	HID_KEYBOARD_COLLECTION,
+	HID_MOUSE_COLLECTION,
+#if HID_VENDOR_COLLECTION_LENGTH
+	HID_VENDOR_COLLECTION_BEGIN,
+#if ENABLE_HOST_PROJECTION
+	HID_VECTOR_REPORT,
+#endif
+#if ENABLE_PROFILING
+	HID_PROFILE_REPORT,
+#endif
+#if ENABLE_DIAGNOSTICS
+	HID_DIAGNOSTICS_REPORT,
+#endif
+	HID_VENDOR_COLLECTION_END,
+#endif
 };
 
+STATIC_ASSERT(sizeof(usbHidReportDescriptor) == USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH, descriptor_length);
+#if ENABLE_KEYBOARD
+STATIC_ASSERT(sizeof(KeyboardReport) == KEYBOARD_REPORT_LENGTH, keyboard_report_size);
+#endif
+#if ENABLE_MOUSE && ENABLE_HOST_PROJECTION
+STATIC_ASSERT(sizeof(VectorReport) == VECTOR_REPORT_LENGTH, vector_report_size);
+#elif ENABLE_MOUSE
+STATIC_ASSERT(sizeof(MouseReport) == MOUSE_REPORT_LENGTH, mouse_report_size);
+#endif
+// Feature reports are sent through control transfers, which are limited
+// to 254 bytes without USB_CFG_LONG_TRANSFERS
+#if ENABLE_PROFILING
+STATIC_ASSERT(sizeof(ProfilingReport) <= 254, profile_report_size);
+#endif
+#if ENABLE_DIAGNOSTICS
+STATIC_ASSERT(sizeof(DiagnosticsReport) <= 254, diagnostics_report_size);
+#endif
+
 // This device does not support BOOT protocol from HID specification.
 //
 // The keyboard portion is very limited, when compared to actual keyboards,
@@ -206,6 +232,22 @@ __attribute__((externally_visible))
 // full 16-bit range. It also has 3 buttons. That means 2+2+1=5 bytes for
 // the report (plus 1 byte for the report ID).
 //
+// ENABLE_DIGITIZER replaces the mouse by a pen digitizer, with the same
+// report ID and almost the same report layout. X and Y use the full 16-bit
+// range, and the padding after the buttons gets an In Range bit. This bit
+// is cleared when the sensor is not pointing at the screen, and the
+// operating system then stops moving the pointer (the pen is "away"),
+// instead of relying on out-of-range values, which are not ignored by
+// Linux (see linux_usbhid_bug/). The 3 buttons become the Tip, Barrel and
+// Secondary Barrel switches.
+//
+// ENABLE_REPORT_TIMESTAMPS fills the rest of the mouse report (up to the 8
+// bytes allowed for low-speed devices) with a 5-bit sequence number, in
+// place of the button padding, and the 16-bit device timestamp of the
+// sensor sample used for that position (see clock_timestamp()). These use
+// vendor-defined usages, which are ignored by the operating system, and
+// are meant for host_tools/report_latency.py.
+//
 // Redundant entries (such as LOGICAL_MINIMUM and USAGE_PAGE) have been
 // commented out where possible, in order to save a few bytes.
 //
@@ -222,6 +264,26 @@ __attribute__((externally_visible))
 // Also note that ENABLE_KEYBOARD and ENABLE_MOUSE options don't change the
 // HID Descriptor. Instead, they only enable/disable the code that
 // implements the keyboard or the mouse.
+//
+// The vendor-defined collection, on the other hand, only exists if any of
+// its reports has been enabled:
+//
+// * ENABLE_HOST_PROJECTION adds the vector report (ID 3), which carries
+//   the raw (but already zero-compensated) X, Y, Z values from the sensor,
+//   plus one byte with the buttons and flags (see VectorReport in
+//   mouseemu.h). Vendor usages were chosen on purpose, so that the
+//   operating system does not interpret this report by itself; the
+//   daemon from host_tools/ reads it through hidraw. Since the mouse
+//   collection is still there, the X, Y values are never out-of-range in
+//   this mode, they are just never sent.
+//
+// * ENABLE_PROFILING adds a feature report (ID 4) with the cycle counters
+//   from profiling.c, read by host_tools/profile_dump.py. Being a feature
+//   report, it is only transferred when the host asks for it.
+//
+// * ENABLE_DIAGNOSTICS adds another feature report (ID 5), with the
+//   startup timings from diagnostics.c, read by
+//   host_tools/diagnostics_dump.py.
 
 // }}}
 
@@ -248,6 +310,10 @@ static uchar idle_rate;
 #endif
 
 static void hardware_init(void) {  // {{{
+#if ENABLE_DIAGNOSTICS && !ENABLE_ASYNC_STARTUP
+	uchar i;
+#endif
+
 	// Configuring Watchdog to about 2 seconds
 	// See pages 43 and 44 from ATmega8 datasheet
 	// See also http://www.nongnu.org/avr-libc/user-manual/group__avr__watchdog.html
@@ -266,6 +332,28 @@ static void hardware_init(void) {  // {{{
 	// LED pins as output, the other pins as input
 	DDRD = 0 | ALL_LEDS;
 
+	// Disabling Timer0 Interrupt
+	// It's disabled by default, anyway, so this shouldn't be needed
+	TIMSK &= ~(TOIE0);
+
+	// Configuring Timer0 (with main clock at 12MHz)
+	// 0 = No clock (timer stopped)
+	// 1 = Prescaler = 1     =>   0.0213333ms
+	// 2 = Prescaler = 8     =>   0.1706666ms
+	// 3 = Prescaler = 64    =>   1.3653333ms
+	// 4 = Prescaler = 256   =>   5.4613333ms
+	// 5 = Prescaler = 1024  =>  21.8453333ms
+	// 6 = External clock source on T0 pin (falling edge)
+	// 7 = External clock source on T0 pin (rising edge)
+	// See page 72 from ATmega8 datasheet.
+	// Also thanks to http://frank.circleofcurrent.com/cache/avrtimercalc.htm
+	TCCR0 = 3;
+
+	// I'm using Timer0 as a 1.365ms ticker. Every time it overflows, the TOV0
+	// flag in TIFR is set. That flag is checked by clock_poll().
+	// It is started before the USB reset, so that the startup timings of
+	// ENABLE_DIAGNOSTICS include the reset.
+
 	// Doing a USB reset
 	// This is done here because the device might have been reset
 	// by the watchdog or some condition other than power-up.
@@ -279,32 +367,40 @@ static void hardware_init(void) {  // {{{
 	DDRD |= USBMASK;    // Setting as output
 	PORTD &= ~USBMASK;  // Setting as zero
 
+#if ENABLE_ASYNC_STARTUP
+	// The lines are released by the startup loop at main(), which
+	// configures the sensor in the meantime.
+#else
+#if ENABLE_DIAGNOSTICS
+	// Holding this state for at least 10ms, while counting the ticks
+	for (i = 0; i < 15; i++) {
+		_delay_ms(1);
+		clock_poll_no_interrupts();
+	}
+#else
 	_delay_ms(15);  // Holding this state for at least 10ms
+#endif
 
 	DDRD &= ~USBMASK;   // Setting as input
 	//PORTD &= ~USBMASK;  // Pull-ups are already disabled
 
 	// End of USB reset
+#endif
 
-	// Disabling Timer0 Interrupt
-	// It's disabled by default, anyway, so this shouldn't be needed
-	TIMSK &= ~(TOIE0);
-
-	// Configuring Timer0 (with main clock at 12MHz)
-	// 0 = No clock (timer stopped)
-	// 1 = Prescaler = 1     =>   0.0213333ms
-	// 2 = Prescaler = 8     =>   0.1706666ms
-	// 3 = Prescaler = 64    =>   1.3653333ms
-	// 4 = Prescaler = 256   =>   5.4613333ms
-	// 5 = Prescaler = 1024  =>  21.8453333ms
-	// 6 = External clock source on T0 pin (falling edge)
-	// 7 = External clock source on T0 pin (rising edge)
-	// See page 72 from ATmega8 datasheet.
-	// Also thanks to http://frank.circleofcurrent.com/cache/avrtimercalc.htm
-	TCCR0 = 3;
+#if CLOCK_USE_ISR
+	// Except in idle sleep mode, where the interrupt is needed to wake up
+	// the CPU at every tick, with the scheduler, which measures long
+	// iterations, and with the pin change buttons, which timestamp edges
+	// from their own interrupt. See clock.c, idlesleep.c and buttons.c.
+	TIMSK |= (1<<TOIE0);
+#endif
 
-	// I'm using Timer0 as a 1.365ms ticker. Every time it overflows, the TOV0
-	// flag in TIFR is set.
+#if ENABLE_PROFILING
+	// Timer1 is used as a free-running cycle counter (prescaler = 1, normal
+	// mode). See page 99 from ATmega8 datasheet.
+	TCCR1A = 0;
+	TCCR1B = 1;
+#endif
 
 	// I'm not using serial-line debugging
 	//odDebugInit();
@@ -342,7 +438,7 @@ usbFunctionSetup(uchar data[8]) {  // {{{
 			}
 #endif
 
-#if ENABLE_MOUSE
+#if ENABLE_MOUSE && !ENABLE_HOST_PROJECTION
 			if (rq->wValue.bytes[0] == 2) {
 				// Mouse report
 				usbMsgPtr = (void*) &mouse_report;
@@ -350,6 +446,39 @@ usbFunctionSetup(uchar data[8]) {  // {{{
 			}
 #endif
 
+#if ENABLE_MOUSE && ENABLE_HOST_PROJECTION
+			if (rq->wValue.bytes[0] == 3) {
+				// Vector report
+				usbMsgPtr = (void*) &vector_report;
+				return sizeof(vector_report);
+			}
+#endif
+
+#if ENABLE_PROFILING
+			if (rq->wValue.bytes[0] == PROFILE_REPORT_ID) {
+				// Profiling feature report
+				// The counters keep being updated while this is being
+				// transferred (8 bytes at a time), so consecutive fields
+				// may come from slightly different moments.
+#if ENABLE_SCHEDULER
+				profiling_report.scheduler = scheduler.stats;
+#endif
+				usbMsgPtr = (void*) &profiling_report;
+				return sizeof(profiling_report);
+			}
+#endif
+
+#if ENABLE_DIAGNOSTICS
+			if (rq->wValue.bytes[0] == DIAGNOSTICS_REPORT_ID) {
+				// Diagnostics feature report
+#if ENABLE_STACK_MONITOR
+				diagnostics_report.stack_unused = stack_unused_bytes();
+#endif
+				usbMsgPtr = (void*) &diagnostics_report;
+				return sizeof(diagnostics_report);
+			}
+#endif
+
 #if ENABLE_IDLE_RATE
 		} else if (rq->bRequest == USBRQ_HID_GET_IDLE) {
 			usbMsgPtr = &idle_rate;
@@ -367,11 +496,93 @@ usbFunctionSetup(uchar data[8]) {  // {{{
 }  // }}}
 
 
+#if ENABLE_SCHEDULER
+////////////////////////////////////////////////////////////
+// Scheduled tasks                                       {{{
+
+static uchar task_update_buttons() {  // {{{
+	// Debouncing is done once per tick (or at every iteration with
+	// ENABLE_PIN_CHANGE_BUTTONS), see buttons.c
+#if ENABLE_PIN_CHANGE_BUTTONS
+	// Running at every iteration, but the post-click freeze must still be
+	// counted in ticks.
+	static uchar last_tick;
+	uchar tick = ((uchar) clock_ticks != last_tick);
+	last_tick = clock_ticks;
+#else
+	// Running once per tick
+	const uchar tick = 1;
+#endif
+
+	PROFILE_BEGIN(BUTTONS);
+	update_button_state(tick);
+	PROFILE_END(BUTTONS);
+	return SCHEDULER_TASK_DONE;
+}  // }}}
+
+static uchar task_read_sensor() {  // {{{
+	uchar return_code;
+
+	// Continuous reading of sensor data
+	if (!sensor.continuous_reading) {
+		return SCHEDULER_TASK_DONE;
+	}
+
+#if ENABLE_POLL_SYNC
+	// Timed according to the USB host polling
+	PROFILE_BEGIN(SENSOR);
+	pollsync_read_sensor();
+	PROFILE_END(SENSOR);
+	return_code = SENSOR_FUNC_DONE;
+#else
+	// Reading the sensor takes a few iterations of the main loop, because
+	// of the I2C communication.
+	PROFILE_BEGIN(SENSOR);
+	return_code = sensor_read_data_registers();
+	PROFILE_END(SENSOR);
+#endif
+
+	if (return_code == SENSOR_FUNC_STILL_WORKING) {
+		return SCHEDULER_TASK_YIELD;
+	} else {
+		return SCHEDULER_TASK_DONE;
+	}
+}  // }}}
+
+const SchedulerTask scheduler_tasks[] PROGMEM = {
+	// run                  period               deadline             budget
+#if ENABLE_PIN_CHANGE_BUTTONS
+	// Edges are timestamped by the interrupt, but must be seen right away
+	{task_update_buttons,   0,                   SCHEDULER_TICK,      CLOCK_MS(0.1)},
+#else
+	{task_update_buttons,   SCHEDULER_TICK,      SCHEDULER_TICK,      CLOCK_MS(0.1)},
+#endif
+#if ENABLE_POLL_SYNC
+	{task_read_sensor,      0,                   CLOCK_MS(50),        CLOCK_MS(0.5)},
+#else
+	// The sensor is configured for 75Hz measurements.
+	// Reading the values at twice that rate: 6.827ms ~= 146Hz
+	{task_read_sensor,      5 * SCHEDULER_TICK,  SCHEDULER_TICK,      CLOCK_MS(0.5)},
+#endif
+};
+
+// If a task is added or removed, update SCHEDULER_TOTAL_TASKS, and also
+// TASK_NAMES at host_tools/profile_dump.py (same order as above).
+STATIC_ASSERT(sizeof(scheduler_tasks) / sizeof(scheduler_tasks[0]) == SCHEDULER_TOTAL_TASKS, scheduler_total_tasks);
+
+// }}}
+#endif
+
+
 void
 __attribute__ ((noreturn))
 main(void) {  // {{{
+#if !ENABLE_POLL_SYNC && !ENABLE_SCHEDULER
 	uchar sensor_probe_counter = 0;
+#endif
+#if !ENABLE_SCHEDULER || ENABLE_IDLE_RATE
 	uchar timer_overflow = 0;
+#endif
 
 #if ENABLE_IDLE_RATE
 	int idle_counter = 0;
@@ -393,31 +604,131 @@ main(void) {  // {{{
 	usbInit();
 	init_int_eeprom();
 	init_button_state();
+#if ENABLE_POLL_SYNC
+	init_pollsync();
+#endif
+#if ENABLE_PROFILING
+	init_profiling();
+#endif
+#if ENABLE_IDLE_SLEEP
+	init_idlesleep();
+#endif
+#if ENABLE_DIAGNOSTICS
+	init_diagnostics();
+#endif
 
 	wdt_reset();
 	sei();
 
+#if ENABLE_ASYNC_STARTUP
+	// Startup loop  {{{
+	// The USB reset (started at hardware_init()) and the sensor
+	// initialization are done at the same time, without blocking. The
+	// sensor is usually ready well before the end of the reset, but if it
+	// is slow to answer (or missing), usbPoll() is already being called and
+	// the enumeration goes on in parallel.
+	{
+		unsigned int usb_reset_start;
+		uchar usb_reset = 1;
+		uchar sensor_startup_code = SENSOR_FUNC_STILL_WORKING;
+
+		usb_reset_start = clock_timestamp();
+
+		while (usb_reset || sensor_startup_code == SENSOR_FUNC_STILL_WORKING) {
+			wdt_reset();
+			clock_poll();
+
+			if (usb_reset) {
+				// Holding the reset for at least 10ms
+				if (clock_timestamp() - usb_reset_start >= CLOCK_MS(15)) {
+					DDRD &= ~USBMASK;   // Setting as input
+					usb_reset = 0;
+					DIAGNOSTICS_MARK(DIAG_USB_RESET_DONE, usb_reset_done);
+				}
+			} else {
+				usbPoll();
+			}
+
+			// Sensor initialization must be done with interrupts enabled!
+			// It uses I2C (TWI) to configure the sensor.
+			if (sensor_startup_code == SENSOR_FUNC_STILL_WORKING) {
+				sensor_startup_code = sensor_startup();
+				if (sensor_startup_code == SENSOR_FUNC_DONE) {
+					DIAGNOSTICS_MARK(DIAG_SENSOR_READY, sensor_ready);
+				} else if (sensor_startup_code == SENSOR_FUNC_ERROR) {
+					DIAGNOSTICS_MARK(DIAG_SENSOR_MISSING, sensor_ready);
+				}
+			}
+		}
+	}
+#if ENABLE_DIAGNOSTICS
+	diagnostics_report.sensor_probe_attempts = sensor.probe_attempts;
+#endif
+	// }}}
+#else
+	DIAGNOSTICS_MARK(DIAG_USB_RESET_DONE, usb_reset_done);
+
 	// Sensor initialization must be done with interrupts enabled!
 	// It uses I2C (TWI) to configure the sensor.
 	sensor_init_configuration();
 
+	DIAGNOSTICS_MARK(DIAG_SENSOR_READY, sensor_ready);
+#endif
+
 	LED_TURN_ON(GREEN_LED);
 
+#if ENABLE_SCHEDULER
+	scheduler_init();
+#endif
+
 	for (;;) {	// main event loop
+#if ENABLE_PROFILING
+		profile_loop_iteration();
+#endif
+
 		wdt_reset();
+
+		PROFILE_BEGIN(USBPOLL);
 		usbPoll();
+		PROFILE_END(USBPOLL);
+#if ENABLE_SCHEDULER
+		scheduler_usbpoll_called();
+#endif
+#if ENABLE_DIAGNOSTICS
+		if (usbConfiguration) {
+			DIAGNOSTICS_MARK(DIAG_USB_CONFIGURED, usb_configured);
+		}
+#endif
 
-		if (TIFR & (1<<TOV0)) {
-			timer_overflow = 1;
+#if ENABLE_SCHEDULER && !ENABLE_IDLE_RATE
+		// The scheduler only needs the clock ticks
+		clock_poll();
+#else
+		timer_overflow = clock_poll();
+#endif
 
-			// Resetting the Timer0
-			// Setting this bit to one will clear it.
-			TIFR = 1<<TOV0;
-		} else {
-			timer_overflow = 0;
-		}
+#if ENABLE_SCHEDULER
+		// The buttons task runs only once per tick, but a change must be
+		// seen by a single iteration of the main loop.
+		button.changed = 0;
 
+		scheduler_run();
+#else
+		PROFILE_BEGIN(BUTTONS);
 		update_button_state(timer_overflow);
+		PROFILE_END(BUTTONS);
+#endif
+
+#if ENABLE_BUS_RECOVERY
+		// Must be before the sensor reading, which is skipped while
+		// recovering
+		busrecovery_poll();
+#endif
+
+#if ENABLE_CALIBRATION_STORE
+		// Writing the calibration saved while the EEPROM was busy
+		calstore_poll();
+#endif
 
 		// Red LED lights up if there is any kind of error in I2C communication
 		if ( TWI_statusReg.lastTransOK ) {
@@ -441,8 +752,15 @@ main(void) {  // {{{
 			sensor_start_continuous_reading();
 		}
 
+#if !ENABLE_SCHEDULER
 		// Continuous reading of sensor data
 		if (sensor.continuous_reading) {  // {{{
+#if ENABLE_POLL_SYNC
+			// Timed according to the USB host polling
+			PROFILE_BEGIN(SENSOR);
+			pollsync_read_sensor();
+			PROFILE_END(SENSOR);
+#else
 			// Timer is set to 1.365ms
 			if (timer_overflow) {
 				// The sensor is configured for 75Hz measurements.
@@ -457,13 +775,17 @@ main(void) {  // {{{
 				// Time for reading new data!
 				uchar return_code;
 
+				PROFILE_BEGIN(SENSOR);
 				return_code = sensor_read_data_registers();
+				PROFILE_END(SENSOR);
 				if (return_code == SENSOR_FUNC_DONE || return_code == SENSOR_FUNC_ERROR) {
 					// Restart the counter+timer
 					sensor_probe_counter = 5;
 				}
 			}
+#endif
 		}  // }}}
+#endif
 
 #if ENABLE_IDLE_RATE
 		// Timer is set to 1.365ms
@@ -504,11 +826,14 @@ main(void) {  // {{{
 			// Basically, this is the menu system (implemented as keyboard)
 
 #if ENABLE_KEYBOARD
+			PROFILE_BEGIN(MENU);
 			ui_main_code();
+			PROFILE_END(MENU);
 #endif
 		}
 
 		// Sending USB Interrupt-in report
+		PROFILE_BEGIN(REPORT);
 		if(usbInterruptIsReady()) {
 			if (0) {
 				// This useless "if" is here to make all the following
@@ -516,7 +841,7 @@ main(void) {  // {{{
 				// easier to add/remove them using preprocessor directives.
 			}
 #if ENABLE_KEYBOARD
-			else if(string_output_pointer != NULL){
+			else if(output_busy()){
 				// Automatically send keyboard report if there is something
 				// in the buffer
 				send_next_char();
@@ -526,11 +851,32 @@ main(void) {  // {{{
 #if ENABLE_MOUSE
 			else if (button.state & BUTTON_SWITCH) {
 				if (mouse_prepare_next_report()) {
+#if ENABLE_HOST_PROJECTION
+					usbSetInterrupt((void*) &vector_report, sizeof(vector_report));
+#else
 					usbSetInterrupt((void*) &mouse_report, sizeof(mouse_report));
+#endif
+#if ENABLE_DIAGNOSTICS
+					if (mouse_position_ready) {
+						DIAGNOSTICS_MARK(DIAG_FIRST_REPORT, first_report);
+					}
+#endif
+					button_report_sent();
 				}
 			}
 #endif
 		}
+		PROFILE_END(REPORT);
+
+#if ENABLE_POLL_SYNC
+		// Must be after the usbSetInterrupt() calls
+		pollsync_observe_poll();
+#endif
+
+#if ENABLE_IDLE_SLEEP
+		// Nothing else to do until the next interrupt
+		idlesleep_end_of_loop();
+#endif
 	}
 }  // }}}
 
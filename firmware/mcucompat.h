@@ -0,0 +1,44 @@
+/* Name: mcucompat.h
+ *
+ * Register names of the ATmega8, for the pin-compatible ATmega88/168/328.
+ *
+ * The firmware was written for the ATmega8. On its successors, each timer
+ * has its own interrupt mask and flag registers, and a few bits and
+ * vectors were renamed, but they work the same way for what is used here.
+ * Files that touch these registers include this file instead of
+ * <avr/io.h>. See also the MCU option at the Makefile.
+ */
+
+#ifndef __mcucompat_h_included__
+#define __mcucompat_h_included__
+
+#include <avr/io.h>
+
+
+// Timer0
+#ifndef TIFR
+#define TIFR   TIFR0
+#endif
+#ifndef TIMSK
+#define TIMSK  TIMSK0
+#endif
+#ifndef TCCR0
+// The clock select bits (CS02:0) are at the same place of TCCR0B
+#define TCCR0  TCCR0B
+#endif
+
+// EEPROM
+#ifndef EEMWE
+#define EEMWE  EEMPE
+#endif
+#ifndef EEWE
+#define EEWE   EEPE
+#endif
+#ifndef EE_RDY_vect
+#define EE_RDY_vect  EE_READY_vect
+#endif
+
+
+#endif  // __mcucompat_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
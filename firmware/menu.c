@@ -9,59 +9,47 @@
 
 // For NULL definition
 #include <stddef.h>
+// For strchr(), used by append_pgm_string()
+#include <string.h>
 
 #include <avr/pgmspace.h>
 
 #include "buttons.h"
+#include "calstore.h"
 #include "common.h"
 #include "int_eeprom.h"
 #include "keyemu.h"
+#include "overlay.h"
 #include "sensor.h"
 
 #include "menu.h"
 
+#if ENABLE_PACKED_STRINGS && !defined(PACKED_STRINGS_EXTRACT)
+// Generated from the PACKED_STRING() lines below, see pack_strings.py
+#include "packed_strings.h"
+#endif
+
 
 #define BUTTON_PREV    BUTTON_1
 #define BUTTON_NEXT    BUTTON_2
 #define BUTTON_CONFIRM BUTTON_3
 
+// Zero calibration temporary values
+#if ENABLE_RAM_OVERLAY
+#define ZERO_MIN (mode_overlay.menu.zero_min)
+#define ZERO_MAX (mode_overlay.menu.zero_max)
+#else
+#define ZERO_MIN (sens->zero_min)
+#define ZERO_MAX (sens->zero_max)
+#endif
+
 
 ////////////////////////////////////////////////////////////
 // Menu definitions (constants in progmem)               {{{
 
-// All available UI widgets  {{{
-
-// Menus
-// Note: the ROOT (empty) menu must be ZERO
-#define UI_ROOT_MENU    0
-#define UI_MAIN_MENU    1
-#define UI_ZERO_MENU    2
-#define UI_CORNERS_MENU 3
-#define UI_SENSOR_MENU  4
-
-// UI_MIN_MENU_ID must be ZERO
-#define UI_MIN_MENU_ID UI_ROOT_MENU
-#define UI_MAX_MENU_ID UI_SENSOR_MENU
-
 // Checking if a widget is a menu
 #define UI_IS_MENU(id) ((id) >= UI_MIN_MENU_ID && (id) <= UI_MAX_MENU_ID)
 
-// Other widgets
-#define UI_ZERO_PRINT_WIDGET              0x10
-#define UI_ZERO_CAL_WIDGET                0x11
-#define UI_ZERO_TOGGLE_WIDGET             0x12
-#define UI_CORNERS_PRINT_WIDGET           0x13
-#define UI_CORNERS_SET_TOPLEFT_WIDGET     0x14
-#define UI_CORNERS_SET_TOPRIGHT_WIDGET    0x15
-#define UI_CORNERS_SET_BOTTOMLEFT_WIDGET  0x16
-#define UI_CORNERS_SET_BOTTOMRIGHT_WIDGET 0x17
-#define UI_CORNERS_SET_ANYTHING_WIDGET    0x18
-#define UI_SENSOR_ID_WIDGET               0x19
-#define UI_SENSOR_XYZ_ONCE_WIDGET         0x1A
-#define UI_SENSOR_XYZ_CONT_WIDGET         0x1B
-#define UI_KEYBOARD_TEST_WIDGET           0x1C
-// }}}
-
 typedef struct MenuItem {  // {{{
 	// The menu text string pointer
 	PGM_P text;
@@ -69,158 +57,54 @@ typedef struct MenuItem {  // {{{
 	uchar action;
 } MenuItem;  // }}}
 
-// Root/empty menu  {{{
-// Yeah, this is just a "fake" menu with only one empty item.
-
-static const char     empty_menu_1[] PROGMEM = "";
-#define               empty_menu_total_items 1
-static const MenuItem empty_menu_items[] PROGMEM = {
-	{empty_menu_1, UI_MAIN_MENU}
-};
+// Data used by ui_load_menu_items()  {{{
+typedef struct MenuLoadingInfo {
+	// Pointer to the array of MenuItems
+	const MenuItem *menu_items;
+	// Number of items in this menu
+	uchar total_items;
+} MenuLoadingInfo;
 // }}}
 
-// Error menu, for when something goes wrong  {{{
-static const char     error_menu_1[] PROGMEM = "Menu error\n";
-#define               error_menu_total_items 1
-static const MenuItem error_menu_items[] PROGMEM = {
-	{error_menu_1, 0}
-};
+// All menus and UI widgets  {{{
+// The ids, the menu strings, the MenuItem arrays and menu_loading[] are
+// generated from menu_tree.txt, run "make menu" after editing it.
+#include "menu_tree.h"
 // }}}
 
-// Main menu, with all main options  {{{
+// Other zerocal messages  {{{
 #if ENABLE_FULL_MENU
-static const char     main_menu_1[] PROGMEM = "1. Zero calibration >>\n";
-static const char     main_menu_2[] PROGMEM = "2. Corner calibration >>\n";
-static const char     main_menu_3[] PROGMEM = "3. Sensor data >>\n";
-static const char     main_menu_4[] PROGMEM = "4. Keyboard test\n";
-static const char     main_menu_5[] PROGMEM = "5. << quit menu\n";
-#define               main_menu_total_items 5
+PACKED_STRING(zero_calibration_instructions, "Move the sensor to get the maximum and minimum value for each axis. Press the button to finish.\n");
+PACKED_STRING(zero_compensation_prefix, "Zero compensation is ");
+PACKED_STRING(zero_compensation_suffix_on, "ENABLED\n");
+PACKED_STRING(zero_compensation_suffix_off, "DISABLED\n");
 #else
-static const char     main_menu_1[] PROGMEM = "1. Zero >>\n";
-static const char     main_menu_2[] PROGMEM = "2. Corner >>\n";
-static const char     main_menu_3[] PROGMEM = "3. Sensor data >>\n";
-static const char     main_menu_5[] PROGMEM = "4. << quit menu\n";
-#define               main_menu_total_items 4
+//PACKED_STRING(zero_calibration_instructions, "");
+PACKED_STRING(zero_compensation_prefix, "Zero comp. is ");
+PACKED_STRING(zero_compensation_suffix_on, "ON\n");
+PACKED_STRING(zero_compensation_suffix_off, "OFF\n");
 #endif
-
-static const MenuItem main_menu_items[] PROGMEM = {
-	{main_menu_1, UI_ZERO_MENU},
-	{main_menu_2, UI_CORNERS_MENU},
-	{main_menu_3, UI_SENSOR_MENU},
-#if ENABLE_FULL_MENU
-	{main_menu_4, UI_KEYBOARD_TEST_WIDGET},
-#endif
-	{main_menu_5, 0}
-};
 // }}}
 
-// Zero calibration menu  {{{
-static const char     zero_menu_1[] PROGMEM = "1.1. Print zero\n";
-static const char     zero_menu_2[] PROGMEM = "1.2. Recalibrate zero\n";
-static const char     zero_menu_3[] PROGMEM = "1.3. Toggle zero compensation\n";
-static const char     zero_menu_4[] PROGMEM = "1.4. << back\n";
-#define               zero_menu_total_items 4
-static const MenuItem zero_menu_items[] PROGMEM = {
-	{zero_menu_1, UI_ZERO_PRINT_WIDGET},
-	{zero_menu_2, UI_ZERO_CAL_WIDGET},
-	{zero_menu_3, UI_ZERO_TOGGLE_WIDGET},
-	{zero_menu_4, 0}
-};
-
-// Other zerocal messages:
-#if ENABLE_FULL_MENU
-static const char zero_calibration_instructions[] PROGMEM = "Move the sensor to get the maximum and minimum value for each axis. Press the button to finish.\n";
-static const char zero_compensation_prefix[] PROGMEM = "Zero compensation is ";
-static const char zero_compensation_suffix_on[] PROGMEM = "ENABLED\n";
-static const char zero_compensation_suffix_off[] PROGMEM = "DISABLED\n";
-#else
-//static const char zero_calibration_instructions[] PROGMEM = "";
-static const char zero_compensation_prefix[] PROGMEM = "Zero comp. is ";
-static const char zero_compensation_suffix_on[] PROGMEM = "ON\n";
-static const char zero_compensation_suffix_off[] PROGMEM = "OFF\n";
-#endif
-
-// }}}
-
-// Corner calibration menu  {{{
-static const char     corners_menu_1[] PROGMEM = "2.1. Print corners\n";
-static const char     corners_menu_2[] PROGMEM = "2.2. Set topleft\n";
-static const char     corners_menu_3[] PROGMEM = "2.3. Set topright\n";
-static const char     corners_menu_4[] PROGMEM = "2.4. Set bottomleft\n";
-static const char     corners_menu_5[] PROGMEM = "2.5. Set bottomright\n";
-static const char     corners_menu_6[] PROGMEM = "2.6. << back\n";
-#define               corners_menu_total_items 6
-static const MenuItem corners_menu_items[] PROGMEM = {
-	{corners_menu_1, UI_CORNERS_PRINT_WIDGET},
-	{corners_menu_2, UI_CORNERS_SET_TOPLEFT_WIDGET},
-	{corners_menu_3, UI_CORNERS_SET_TOPRIGHT_WIDGET},
-	{corners_menu_4, UI_CORNERS_SET_BOTTOMLEFT_WIDGET},
-	{corners_menu_5, UI_CORNERS_SET_BOTTOMRIGHT_WIDGET},
-	{corners_menu_6, 0}
-};
-
-// Corner names:
+// Corner names  {{{
 // Slightly hacked from the menu strings. Saves about 40 bytes this way.
 static const PGM_P const corners_names[4] PROGMEM = {
-	// +offset = number of characters in "2.x. Set "
-	corners_menu_2 + 9,
-	corners_menu_3 + 9,
-	corners_menu_4 + 9,
-	corners_menu_5 + 9
+	// offset = number of characters in " Set "
+	PACKED_OFFSET(corners_menu_2, 5),
+	PACKED_OFFSET(corners_menu_3, 5),
+	PACKED_OFFSET(corners_menu_4, 5),
+	PACKED_OFFSET(corners_menu_5, 5)
 };
 // }}}
 
-// Sensor data menu  {{{
-#if ENABLE_FULL_MENU
-static const char     sensor_menu_1[] PROGMEM = "3.1. Print sensor identification\n";
-static const char     sensor_menu_2[] PROGMEM = "3.2. Print X,Y,Z once\n";
-static const char     sensor_menu_3[] PROGMEM = "3.3. Print X,Y,Z continually\n";
-static const char     sensor_menu_4[] PROGMEM = "3.4. << back\n";
-#define               sensor_menu_total_items 4
-#else
-static const char     sensor_menu_2[] PROGMEM = "3.1. Print X,Y,Z once\n";
-static const char     sensor_menu_3[] PROGMEM = "3.2. Print X,Y,Z continually\n";
-static const char     sensor_menu_4[] PROGMEM = "3.3. << back\n";
-#define               sensor_menu_total_items 3
-#endif
-
-static const MenuItem sensor_menu_items[] PROGMEM = {
-#if ENABLE_FULL_MENU
-	{sensor_menu_1, UI_SENSOR_ID_WIDGET},
-#endif
-	{sensor_menu_2, UI_SENSOR_XYZ_ONCE_WIDGET},
-	{sensor_menu_3, UI_SENSOR_XYZ_CONT_WIDGET},
-	{sensor_menu_4, 0}
-};
-
-// Error message:
-static const char  error_sensor_string[] PROGMEM = "Sensor reading error\n";
+// Sensor error message  {{{
+PACKED_STRING(error_sensor_string, "Sensor reading error\n");
 // }}}
 
 #if ENABLE_FULL_MENU
-static const char keyboard_test_string[] PROGMEM = "AAaaAAaaZz 0123456789 !@#$%&*() -_ =+ ,< .> ;: /?\n";
+PACKED_STRING(keyboard_test_string, "AAaaAAaaZz 0123456789 !@#$%&*() -_ =+ ,< .> ;: /?\n");
 #endif
 
-// Data used by ui_load_menu_items()  {{{
-typedef struct MenuLoadingInfo {
-	// Pointer to the array of MenuItems
-	PGM_VOID_P menu_items;
-	// Number of items in this menu
-	uchar total_items;
-} MenuLoadingInfo;
-
-#define MENU_LOADING(prefix) {prefix##_menu_items, prefix##_menu_total_items}
-static const MenuLoadingInfo menu_loading[] PROGMEM = {
-	MENU_LOADING(error),  // The error menu is at element 0
-	MENU_LOADING(empty),  // And the UI with id ZERO starts at element 1
-	MENU_LOADING(main),
-	MENU_LOADING(zero),
-	MENU_LOADING(corners),
-	MENU_LOADING(sensor)
-};
-#undef MENU_LOADING
-// }}}
-
 // }}}
 
 
@@ -237,12 +121,17 @@ typedef struct UIState {
 // Current UI state
 UIState ui;
 
-// At most 5 stacked widgets. This value is arbitrary.
-UIState ui_stack[5];
+// The deepest chain of widgets is computed by gen_menu.py
+UIState ui_stack[UI_STACK_SIZE];
 uchar ui_stack_top;
 
-// Each menu can have at most 7 menu items. This value is arbitrary.
-static MenuItem ui_menu_items[7];
+#if ENABLE_OUTPUT_QUEUE
+// ui_print_menu_item() queues one number per level, plus the item text
+STATIC_ASSERT(UI_STACK_SIZE <= OUTPUT_QUEUE_SIZE, ui_print_menu_item_segments);
+#endif
+
+// Items of the current menu, read directly from PROGMEM
+static const MenuItem *ui_menu_items;
 static uchar ui_menu_total_items;
 
 // Should the current menu item be printed in the next ui_main_code() call?
@@ -250,6 +139,11 @@ static uchar ui_menu_total_items;
 // and the current menu item will be printed whenever it is appropriate.
 uchar ui_should_print_menu_item;
 
+#if ENABLE_COMPACT_XYZ
+// Line counter of UI_SENSOR_XYZ_COMPACT_WIDGET, lets the host find lost lines
+static uchar xyz_compact_seq;
+#endif
+
 // }}}
 
 
@@ -257,12 +151,10 @@ uchar ui_should_print_menu_item;
 // UI and menu handling functions                        {{{
 
 static void ui_load_menu_items() {  // {{{
-	// Loads the menu strings from PROGMEM to RAM
+	// Points ui_menu_items to the current menu, in PROGMEM
 
 	// Load from this id
 	uchar id;
-	// Pointer to the source address
-	PGM_VOID_P menu_items;
 
 	if (UI_IS_MENU(ui.widget_id)) {
 		id = ui.widget_id - UI_MIN_MENU_ID + 1;
@@ -271,15 +163,49 @@ static void ui_load_menu_items() {  // {{{
 	}
 
 	// This version is more portable:
-	//memcpy_P(&menu_items, &menu_loading[id].menu_items, sizeof(PGM_P));
+	//memcpy_P(&ui_menu_items, &menu_loading[id].menu_items, sizeof(PGM_P));
 	// But this version is shorter (40 bytes smaller):
 	// But this assertion must be true: assert(sizeof(PGM_VOID_P) == 2)
-	menu_items = (PGM_VOID_P) pgm_read_word_near(&menu_loading[id].menu_items);
+	ui_menu_items = (const MenuItem *) pgm_read_word_near(&menu_loading[id].menu_items);
 
 	ui_menu_total_items = pgm_read_byte_near(&menu_loading[id].total_items);
+}  // }}}
+
+static void ui_print_menu_item() {  // {{{
+	// Types the number of the current menu item ("1.2.") and its text.
+	// Each level of the number is the item selected in one of the parent
+	// menus, the root menu (at the bottom of the stack) has no number.
+
+	uchar i;
+	PGM_P text;
+#if !ENABLE_OUTPUT_QUEUE
+	uchar *str = string_output_buffer;
+#endif
+
+	text = (PGM_P) pgm_read_word_near(&ui_menu_items[ui.menu_item].text);
 
-	// Copying to RAM array ui_menu_items
-	memcpy_P(ui_menu_items, menu_items, ui_menu_total_items * sizeof(*ui_menu_items));
+#if ENABLE_OUTPUT_QUEUE
+	if (ui_stack_top > 0) {
+		for (i = 1; i < ui_stack_top; i++) {
+			output_int(ui_stack[i].menu_item + 1, '.');
+		}
+		output_int(ui.menu_item + 1, '.');
+	}
+	output_pgm_string(text);
+#else
+	if (ui_stack_top > 0) {
+		for (i = 1; i < ui_stack_top; i++) {
+			str = int_to_dec(ui_stack[i].menu_item + 1, str);
+			*str++ = '.';
+		}
+		str = int_to_dec(ui.menu_item + 1, str);
+		*str++ = '.';
+	}
+	*str = '\0';
+
+	append_pgm_string(string_output_buffer, text);
+	string_output_pointer = string_output_buffer;
+#endif
 }  // }}}
 
 static void ui_push_state() {  // {{{
@@ -348,6 +274,10 @@ void init_ui_system() {   // {{{
 	// Emptying the stack
 	ui_stack_top = 0;
 
+#if ENABLE_RAM_OVERLAY
+	mode_overlay_claim(OVERLAY_MENU);
+#endif
+
 	// Calling ui_pop_state() with an empty stack will reload the initial
 	// widget (the root/empty menu).
 	ui_pop_state();
@@ -357,8 +287,8 @@ static void ui_menu_code() {  // {{{
 
 	// If the current menu item needs to be printed and the firmware is not
 	// busy printing something else
-	if (ui_should_print_menu_item && string_output_pointer == NULL) {
-		output_pgm_string(ui_menu_items[ui.menu_item].text);
+	if (ui_should_print_menu_item && !output_busy()) {
+		ui_print_menu_item();
 		ui_should_print_menu_item = 0;
 	}
 
@@ -369,7 +299,7 @@ static void ui_menu_code() {  // {{{
 		ui_next_menu_item();
 	} else if (ON_KEY_DOWN(BUTTON_CONFIRM)) {
 		uchar action;
-		action = ui_menu_items[ui.menu_item].action;
+		action = pgm_read_byte_near(&ui_menu_items[ui.menu_item].action);
 
 		if (action == 0) {
 			ui_pop_state();
@@ -395,21 +325,32 @@ void ui_main_code() {  // {{{
 		switch (ui.widget_id) {
 			////////////////////
 			case UI_ZERO_PRINT_WIDGET:  // {{{
-				if (string_output_pointer != NULL) {
+				if (output_busy()) {
 					// Do nothing, let's wait the previous output...
 				} else {
+#if ENABLE_OUTPUT_QUEUE
+					// Printing X,Y,Z zero and the boolean value
+					output_xyz_vector(&sens->e.zero);
+					output_pgm_string(zero_compensation_prefix);
+					if (sens->e.zero_compensation) {
+						output_pgm_string(zero_compensation_suffix_on);
+					} else {
+						output_pgm_string(zero_compensation_suffix_off);
+					}
+#else
 					// Printing X,Y,Z zero...
 					XYZVector_to_string(&sens->e.zero, string_output_buffer);
 
 					// ...and the boolean value
-					strcat_P(string_output_buffer, zero_compensation_prefix);
+					append_pgm_string(string_output_buffer, zero_compensation_prefix);
 					if (sens->e.zero_compensation) {
-						strcat_P(string_output_buffer, zero_compensation_suffix_on);
+						append_pgm_string(string_output_buffer, zero_compensation_suffix_on);
 					} else {
-						strcat_P(string_output_buffer, zero_compensation_suffix_off);
+						append_pgm_string(string_output_buffer, zero_compensation_suffix_off);
 					}
 
 					string_output_pointer = string_output_buffer;
+#endif
 					ui_pop_state();
 				}
 				break;  // }}}
@@ -417,7 +358,7 @@ void ui_main_code() {  // {{{
 			////////////////////
 			case UI_ZERO_CAL_WIDGET:  // {{{
 				if (ui.menu_item == 0) {
-					if (string_output_pointer != NULL) {
+					if (output_busy()) {
 						// Do nothing, let's wait the previous output...
 						break;
 					}
@@ -438,11 +379,11 @@ void ui_main_code() {  // {{{
 						sens->new_data_available = 0;
 
 						if (!sens->overflow) {
-							sens->zero_min = sens->data;
-							sens->zero_max = sens->data;
+							ZERO_MIN = sens->data;
+							ZERO_MAX = sens->data;
 							// Using memcpy costs a few more bytes than simple attribution
-							//memcpy(&sens->zero_min, &sens->data, sizeof(sens->data));
-							//memcpy(&sens->zero_max, &sens->data, sizeof(sens->data));
+							//memcpy(&ZERO_MIN, &sens->data, sizeof(sens->data));
+							//memcpy(&ZERO_MAX, &sens->data, sizeof(sens->data));
 
 							ui.menu_item = 2;
 						}
@@ -453,17 +394,16 @@ void ui_main_code() {  // {{{
 
 						if (!sens->overflow) {
 							// The following 6 if statements cost 96 bytes
-							if (sens->data.x < sens->zero_min.x) sens->zero_min.x = sens->data.x;
-							if (sens->data.y < sens->zero_min.y) sens->zero_min.y = sens->data.y;
-							if (sens->data.z < sens->zero_min.z) sens->zero_min.z = sens->data.z;
+							if (sens->data.x < ZERO_MIN.x) ZERO_MIN.x = sens->data.x;
+							if (sens->data.y < ZERO_MIN.y) ZERO_MIN.y = sens->data.y;
+							if (sens->data.z < ZERO_MIN.z) ZERO_MIN.z = sens->data.z;
 
-							if (sens->data.x > sens->zero_max.x) sens->zero_max.x = sens->data.x;
-							if (sens->data.y > sens->zero_max.y) sens->zero_max.y = sens->data.y;
-							if (sens->data.z > sens->zero_max.z) sens->zero_max.z = sens->data.z;
+							if (sens->data.x > ZERO_MAX.x) ZERO_MAX.x = sens->data.x;
+							if (sens->data.y > ZERO_MAX.y) ZERO_MAX.y = sens->data.y;
+							if (sens->data.z > ZERO_MAX.z) ZERO_MAX.z = sens->data.z;
 
-							if (string_output_pointer == NULL) {
-								XYZVector_to_string(&sens->data, string_output_buffer);
-								string_output_pointer = string_output_buffer;
+							if (!output_busy()) {
+								output_xyz_vector(&sens->data);
 							}
 						}
 					}
@@ -471,9 +411,9 @@ void ui_main_code() {  // {{{
 					if (ON_KEY_DOWN(BUTTON_CONFIRM)) {
 						sensor_stop_continuous_reading();
 
-						sens->e.zero.x = (sens->zero_min.x + sens->zero_max.x) / 2;
-						sens->e.zero.y = (sens->zero_min.y + sens->zero_max.y) / 2;
-						sens->e.zero.z = (sens->zero_min.z + sens->zero_max.z) / 2;
+						sens->e.zero.x = (ZERO_MIN.x + ZERO_MAX.x) / 2;
+						sens->e.zero.y = (ZERO_MIN.y + ZERO_MAX.y) / 2;
+						sens->e.zero.z = (ZERO_MIN.z + ZERO_MAX.z) / 2;
 
 						sens->e.zero_compensation = 1;
 
@@ -481,11 +421,15 @@ void ui_main_code() {  // {{{
 						// I could save the entire EEPROM block, but instead
 						// I'm saving only the boolean zero_compensation and
 						// the XYZVector zero.
+#if ENABLE_CALIBRATION_STORE
+						calstore_save();
+#else
 						int_eeprom_write_block(
 							&sens->e.zero_compensation,
 							&eeprom_sensor.zero_compensation,
 							(1 + sizeof(XYZVector))
 						);
+#endif
 
 						ui_pop_state();
 						ui_enter_widget(UI_ZERO_PRINT_WIDGET);
@@ -499,11 +443,15 @@ void ui_main_code() {  // {{{
 				sens->e.zero_compensation = !sens->e.zero_compensation;
 
 				// Saving to EEPROM
+#if ENABLE_CALIBRATION_STORE
+				calstore_save();
+#else
 				int_eeprom_write_block(
 					&sens->e.zero_compensation,
 					&eeprom_sensor.zero_compensation,
 					1
 				);
+#endif
 
 				ui_pop_state();
 				ui_enter_widget(UI_ZERO_PRINT_WIDGET);
@@ -512,7 +460,7 @@ void ui_main_code() {  // {{{
 
 			////////////////////
 			case UI_CORNERS_PRINT_WIDGET:  // {{{
-				if (string_output_pointer != NULL) {
+				if (output_busy()) {
 					// Do nothing, let's wait the previous output...
 				} else {
 					if (ui.menu_item % 2 == 0) {
@@ -524,8 +472,7 @@ void ui_main_code() {  // {{{
 						);
 					} else {
 						// Print the corner value
-						XYZVector_to_string(&sens->e.corners[ui.menu_item / 2], string_output_buffer);
-						string_output_pointer = string_output_buffer;
+						output_xyz_vector(&sens->e.corners[ui.menu_item / 2]);
 					}
 
 					ui.menu_item++;
@@ -551,7 +498,7 @@ void ui_main_code() {  // {{{
 
 			////////////////////
 			case UI_CORNERS_SET_ANYTHING_WIDGET:  // {{{
-				if (string_output_pointer == NULL
+				if (!output_busy()
 					&& button.state & BUTTON_CONFIRM
 					&& sens->new_data_available
 					&& !sens->overflow
@@ -561,15 +508,18 @@ void ui_main_code() {  // {{{
 
 					// Saving
 					sens->e.corners[ui.menu_item] = sens->data;
+#if ENABLE_CALIBRATION_STORE
+					calstore_save();
+#else
 					int_eeprom_write_block(
 						&sens->e.corners[ui.menu_item],
 						&eeprom_sensor.corners[ui.menu_item],
 						sizeof(XYZVector)
 					);
+#endif
 
 					// Printing
-					XYZVector_to_string(&sens->data, string_output_buffer);
-					string_output_pointer = string_output_buffer;
+					output_xyz_vector(&sens->data);
 
 					ui_pop_state();
 				}
@@ -579,10 +529,17 @@ void ui_main_code() {  // {{{
 #if ENABLE_FULL_MENU
 			////////////////////
 			case UI_SENSOR_ID_WIDGET:  // {{{
-				if (string_output_pointer != NULL) {
+				if (output_busy()) {
 					// Do nothing, let's wait the previous output...
 					break;
 				}
+#if ENABLE_BUS_RECOVERY
+				if (sens->recovering) {
+					// busrecovery.c is probing the sensor with the same
+					// functions, let's wait for it...
+					break;
+				}
+#endif
 				if (ui.menu_item == 0) {
 					sens->func_step = 0;
 					ui.menu_item = 1;
@@ -597,7 +554,7 @@ void ui_main_code() {  // {{{
 					//append_newline_to_str(string_output_buffer);
 					// But it adds 18 bytes to the firmware
 
-					string_output_pointer = string_output_buffer;
+					output_ram_string(string_output_buffer);
 					ui_pop_state();
 				} else if (return_code == SENSOR_FUNC_ERROR) {
 					output_pgm_string(error_sensor_string);
@@ -609,19 +566,27 @@ void ui_main_code() {  // {{{
 			////////////////////
 			case UI_SENSOR_XYZ_ONCE_WIDGET:  // {{{
 			case UI_SENSOR_XYZ_CONT_WIDGET:
+#if ENABLE_COMPACT_XYZ
+			case UI_SENSOR_XYZ_COMPACT_WIDGET:
+#endif
 				if (ui.menu_item == 0) {
-					if (string_output_pointer != NULL) {
+					if (output_busy()) {
 						// Do nothing, let's wait the previous output...
 						break;
 					}
 					sensor_start_continuous_reading();
 					ui.menu_item = 1;  // Started reading, but nothing printed yet.
 				} else {
-					if (string_output_pointer == NULL) {
+					if (!output_busy()) {
 						if (sens->new_data_available) {
 							sens->new_data_available = 0;
-							XYZVector_to_string(&sens->data, string_output_buffer);
-							string_output_pointer = string_output_buffer;
+#if ENABLE_COMPACT_XYZ
+							if (ui.widget_id == UI_SENSOR_XYZ_COMPACT_WIDGET) {
+								output_xyz_compact(&sens->data, xyz_compact_seq);
+								xyz_compact_seq++;
+							} else
+#endif
+							output_xyz_vector(&sens->data);
 							ui.menu_item = 2;  // At least one thing has been printed
 						} else if (sens->error_while_reading) {
 							output_pgm_string(error_sensor_string);
@@ -643,13 +608,33 @@ void ui_main_code() {  // {{{
 #if ENABLE_FULL_MENU
 			////////////////////
 			case UI_KEYBOARD_TEST_WIDGET:  // {{{
-				if (string_output_pointer == NULL) {
+				if (!output_busy()) {
 					output_pgm_string(keyboard_test_string);
 					ui_pop_state();
 				}
 				break;  // }}}
 #endif
 
+#if ENABLE_CALIBRATION_STORE
+			////////////////////
+			case UI_PROFILE_NEXT_WIDGET:  // {{{
+				if (!output_busy()) {
+					uchar profile = calstore.active + 1;
+					if (profile == CALSTORE_PROFILES) profile = 0;
+
+					calstore_switch_profile(profile);
+
+					// Printing the new profile name
+					output_pgm_string(
+						(PGM_VOID_P) pgm_read_word_near(
+							&calstore_profile_names[profile]
+						)
+					);
+					ui_pop_state();
+				}
+				break;  // }}}
+#endif
+
 			default:
 				// Fallback in case of errors
 				ui_pop_state();
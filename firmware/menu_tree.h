@@ -0,0 +1,160 @@
+/* Name: menu_tree.h
+ *
+ * Generated by gen_menu.py from menu_tree.txt, do not edit.
+ */
+
+#ifndef __menu_tree_h_included__
+#define __menu_tree_h_included__
+
+
+// Menus
+// Note: the ROOT (empty) menu must be ZERO
+#define UI_ROOT_MENU 0
+#define UI_MAIN_MENU 1
+#define UI_ZERO_MENU 2
+#define UI_CORNERS_MENU 3
+#define UI_SENSOR_MENU 4
+
+// UI_MIN_MENU_ID must be ZERO
+#define UI_MIN_MENU_ID UI_ROOT_MENU
+#define UI_MAX_MENU_ID UI_SENSOR_MENU
+
+// Other widgets
+#define UI_KEYBOARD_TEST_WIDGET 0x10
+#define UI_PROFILE_NEXT_WIDGET 0x11
+#define UI_ZERO_PRINT_WIDGET 0x12
+#define UI_ZERO_CAL_WIDGET 0x13
+#define UI_ZERO_TOGGLE_WIDGET 0x14
+#define UI_CORNERS_PRINT_WIDGET 0x15
+#define UI_CORNERS_SET_TOPLEFT_WIDGET 0x16
+#define UI_CORNERS_SET_TOPRIGHT_WIDGET 0x17
+#define UI_CORNERS_SET_BOTTOMLEFT_WIDGET 0x18
+#define UI_CORNERS_SET_BOTTOMRIGHT_WIDGET 0x19
+#define UI_CORNERS_SET_ANYTHING_WIDGET 0x1A
+#define UI_SENSOR_ID_WIDGET 0x1B
+#define UI_SENSOR_XYZ_ONCE_WIDGET 0x1C
+#define UI_SENSOR_XYZ_CONT_WIDGET 0x1D
+#define UI_SENSOR_XYZ_COMPACT_WIDGET 0x1E
+
+
+// Root/empty menu
+// Yeah, this is just a "fake" menu with only one empty item.
+PACKED_STRING(empty_menu_1, "");
+static const MenuItem empty_menu_items[] PROGMEM = {
+	{empty_menu_1, UI_MAIN_MENU}
+};
+
+// Error menu, for when something goes wrong
+PACKED_STRING(error_menu_1, " Menu error\n");
+static const MenuItem error_menu_items[] PROGMEM = {
+	{error_menu_1, 0}
+};
+
+
+// Main menu
+#if ENABLE_FULL_MENU
+PACKED_STRING(main_menu_1, " Zero calibration >>\n");
+#else
+PACKED_STRING(main_menu_1, " Zero >>\n");
+#endif
+#if ENABLE_FULL_MENU
+PACKED_STRING(main_menu_2, " Corner calibration >>\n");
+#else
+PACKED_STRING(main_menu_2, " Corner >>\n");
+#endif
+PACKED_STRING(main_menu_3, " Sensor data >>\n");
+#if ENABLE_FULL_MENU
+PACKED_STRING(main_menu_4, " Keyboard test\n");
+#endif
+#if ENABLE_CALIBRATION_STORE
+#if ENABLE_FULL_MENU
+PACKED_STRING(main_menu_5, " Next calibration profile\n");
+#else
+PACKED_STRING(main_menu_5, " Next profile\n");
+#endif
+#endif
+PACKED_STRING(main_menu_6, " << quit menu\n");
+static const MenuItem main_menu_items[] PROGMEM = {
+	{main_menu_1, UI_ZERO_MENU},
+	{main_menu_2, UI_CORNERS_MENU},
+	{main_menu_3, UI_SENSOR_MENU},
+#if ENABLE_FULL_MENU
+	{main_menu_4, UI_KEYBOARD_TEST_WIDGET},
+#endif
+#if ENABLE_CALIBRATION_STORE
+	{main_menu_5, UI_PROFILE_NEXT_WIDGET},
+#endif
+	{main_menu_6, 0},
+};
+#define main_menu_total_items (sizeof(main_menu_items) / sizeof(MenuItem))
+
+// Zero menu
+PACKED_STRING(zero_menu_1, " Print zero\n");
+PACKED_STRING(zero_menu_2, " Recalibrate zero\n");
+PACKED_STRING(zero_menu_3, " Toggle zero compensation\n");
+PACKED_STRING(zero_menu_4, " << back\n");
+static const MenuItem zero_menu_items[] PROGMEM = {
+	{zero_menu_1, UI_ZERO_PRINT_WIDGET},
+	{zero_menu_2, UI_ZERO_CAL_WIDGET},
+	{zero_menu_3, UI_ZERO_TOGGLE_WIDGET},
+	{zero_menu_4, 0},
+};
+#define zero_menu_total_items (sizeof(zero_menu_items) / sizeof(MenuItem))
+
+// Corners menu
+PACKED_STRING(corners_menu_1, " Print corners\n");
+PACKED_STRING(corners_menu_2, " Set topleft\n");
+PACKED_STRING(corners_menu_3, " Set topright\n");
+PACKED_STRING(corners_menu_4, " Set bottomleft\n");
+PACKED_STRING(corners_menu_5, " Set bottomright\n");
+PACKED_STRING(corners_menu_6, " << back\n");
+static const MenuItem corners_menu_items[] PROGMEM = {
+	{corners_menu_1, UI_CORNERS_PRINT_WIDGET},
+	{corners_menu_2, UI_CORNERS_SET_TOPLEFT_WIDGET},
+	{corners_menu_3, UI_CORNERS_SET_TOPRIGHT_WIDGET},
+	{corners_menu_4, UI_CORNERS_SET_BOTTOMLEFT_WIDGET},
+	{corners_menu_5, UI_CORNERS_SET_BOTTOMRIGHT_WIDGET},
+	{corners_menu_6, 0},
+};
+#define corners_menu_total_items (sizeof(corners_menu_items) / sizeof(MenuItem))
+
+// Sensor menu
+#if ENABLE_FULL_MENU
+PACKED_STRING(sensor_menu_1, " Print sensor identification\n");
+#endif
+PACKED_STRING(sensor_menu_2, " Print X,Y,Z once\n");
+PACKED_STRING(sensor_menu_3, " Print X,Y,Z continually\n");
+#if ENABLE_COMPACT_XYZ
+PACKED_STRING(sensor_menu_4, " Print X,Y,Z compact\n");
+#endif
+PACKED_STRING(sensor_menu_5, " << back\n");
+static const MenuItem sensor_menu_items[] PROGMEM = {
+#if ENABLE_FULL_MENU
+	{sensor_menu_1, UI_SENSOR_ID_WIDGET},
+#endif
+	{sensor_menu_2, UI_SENSOR_XYZ_ONCE_WIDGET},
+	{sensor_menu_3, UI_SENSOR_XYZ_CONT_WIDGET},
+#if ENABLE_COMPACT_XYZ
+	{sensor_menu_4, UI_SENSOR_XYZ_COMPACT_WIDGET},
+#endif
+	{sensor_menu_5, 0},
+};
+#define sensor_menu_total_items (sizeof(sensor_menu_items) / sizeof(MenuItem))
+
+
+// Used by ui_load_menu_items(), indexed by the menu id plus one
+static const MenuLoadingInfo menu_loading[] PROGMEM = {
+	{error_menu_items, 1},
+	{empty_menu_items, 1},
+	{main_menu_items, main_menu_total_items},
+	{zero_menu_items, zero_menu_total_items},
+	{corners_menu_items, corners_menu_total_items},
+	{sensor_menu_items, sensor_menu_total_items}
+};
+
+// Deepest chain of ui_enter_widget() calls, starting from the root menu.
+// Widgets must call ui_pop_state() before entering another widget.
+#define UI_STACK_SIZE 3
+
+
+#endif  // __menu_tree_h_included____
@@ -12,20 +12,132 @@
 #include "buttons.h"
 #include "common.h"
 #include "mouseemu.h"
+#include "overlay.h"
+#include "profiling.h"
 
 
+#if ENABLE_DIAGNOSTICS
+uchar mouse_position_ready;
+#endif
+
+
+#if ENABLE_HOST_PROJECTION
+
 // HID report
-MouseReport mouse_report;
+VectorReport vector_report;
 
-typedef struct SmoothingVars {
-	float first;
-	float second;
-} SmoothingVars;
 
-SmoothingVars mouse_smooth[2];
+void init_mouse_emulation() {  // {{{
+	// According to avr-libc FAQ, the compiler automatically initializes
+	// all variables with zero.
+	vector_report.report_id = VECTOR_REPORT_ID;
+}  // }}}
+
+
+uchar mouse_prepare_next_report() {  // {{{
+	// Return 1 if a new report is available and should be sent to the
+	// computer.
+	//
+	// In this mode, the firmware does no math at all. The vector is sent
+	// exactly as read from the sensor (after the zero compensation, which
+	// is already done in sensor.c), and the computer does the rest. There
+	// is also no "freeze after click" here, that is also up to the
+	// computer.
+
+	SensorData *sens = &sensor;
+	FIX_POINTER(sens);
+
+	VectorReport *repptr = &vector_report;
+	FIX_POINTER(repptr);
+
+	uchar new_flags;
+	uchar modified;
+
+	// Since the 3 buttons are already at the 3 least significant bits, no
+	// complicated conversion is need.
+	new_flags = button.state & VECTOR_FLAG_BUTTONS;
+
+	if (sens->new_data_available) {
+		// Marking the data as "used"
+		sens->new_data_available = 0;
+
+		repptr->x = sens->data.x;
+		repptr->y = sens->data.y;
+		repptr->z = sens->data.z;
+		modified = 1;
+#if ENABLE_DIAGNOSTICS
+		mouse_position_ready = 1;
+#endif
+	} else {
+		modified = 0;
+	}
+
+	if (sens->overflow) {
+		new_flags |= VECTOR_FLAG_OVERFLOW;
+	}
 
+	if (new_flags != repptr->flags) {
+		repptr->flags = new_flags;
+		modified = 1;
+	}
 
-int apply_smoothing(uchar index, float *value_ptr) {
+	return modified;
+}  // }}}
+
+#else  // ENABLE_HOST_PROJECTION
+
+// HID report
+MouseReport mouse_report;
+
+#if !ENABLE_RAM_OVERLAY
+SmoothingVars mouse_smooth[2];
+#endif
+
+
+#if ENABLE_REPORT_GATE
+// A new position is only sent if it differs from the last sent position by
+// more than this threshold (in MouseReport units), in either axis.
+#ifndef MOUSE_REPORT_THRESHOLD
+#define MOUSE_REPORT_THRESHOLD 2
+#endif
+
+// But after this many suppressed positions (i.e. sensor readings) in a row,
+// the report is sent anyway. The sensor is read at about 146Hz, so 64
+// readings are about 440ms.
+#define MOUSE_REPORT_KEEPALIVE 64
+
+#if !ENABLE_RAM_OVERLAY
+MouseGate mouse_gate;
+#endif
+#endif
+
+
+#if ENABLE_CLICK_REWIND
+// The buttons are not attached to the sensor, but the hand that holds the
+// sensor is also the one that clicks, so the pointer jerks a bit around
+// each click. The jerk starts before the press is registered (there are
+// 11ms of debouncing, plus the reaction of the smoothing), so the
+// positions from the last MOUSE_REWIND_SAMPLES sensor readings (about 6.8ms
+// each) are kept, and the click is sent at the oldest of them. That is
+// MOUSE_REWIND_SAMPLES-1 readings before the latest one.
+#ifndef MOUSE_REWIND_SAMPLES
+#define MOUSE_REWIND_SAMPLES 4
+#endif
+
+// While a button is held, the pointer stays at the clicked position until
+// the current position is farther than this (in MouseReport units, in
+// either axis). Then it follows the sensor again, which starts a drag.
+#ifndef MOUSE_DRAG_THRESHOLD
+#define MOUSE_DRAG_THRESHOLD (MOUSE_AXIS_MAX / 64)
+#endif
+
+#if !ENABLE_RAM_OVERLAY
+MouseHistory mouse_history;
+#endif
+#endif
+
+
+MOUSE_AXIS_TYPE apply_smoothing(uchar index, float *value_ptr) {
 	// Brown's double exponential smoothing
 	// http://en.wikipedia.org/wiki/Exponential_smoothing
 
@@ -42,7 +154,7 @@ int apply_smoothing(uchar index, float *value_ptr) {
 	if      (SECOND < 0.0)  SECOND = 0.0;
 	else if (SECOND > 1.0)  SECOND = 1.0;
 
-	return (int) round(SECOND * 32767);
+	return (MOUSE_AXIS_TYPE) round(SECOND * MOUSE_AXIS_MAX);
 
 #undef ALPHA
 #undef FIRST
@@ -53,7 +165,7 @@ int apply_smoothing(uchar index, float *value_ptr) {
 void init_mouse_emulation() {  // {{{
 	// According to avr-libc FAQ, the compiler automatically initializes
 	// all variables with zero.
-	mouse_report.report_id = 2;
+	mouse_report.report_id = MOUSE_REPORT_ID;
 	mouse_report.x = -1;
 	mouse_report.y = -1;
 	//mouse_report.buttons = 0;
@@ -160,7 +272,7 @@ static uchar mouse_axes_linear_equation_system() {  // {{{
 
 	uchar y;
 
-	int final_x, final_y;
+	MOUSE_AXIS_TYPE final_x, final_y;
 
 	fill_matrix_from_sensor(m);
 
@@ -245,6 +357,20 @@ static uchar mouse_axes_linear_equation_system() {  // {{{
 }  // }}}
 
 
+#if ENABLE_DIGITIZER
+static uchar mouse_set_out_of_range() {  // {{{
+	// Clears the In Range bit.
+	// Return 1 if it was set (and thus the report should be sent to the
+	// computer).
+
+	uchar modified = mouse_report.in_range;
+
+	mouse_report.in_range = 0;
+	return modified;
+}  // }}}
+#endif
+
+
 static uchar mouse_update_axes() {  // {{{
 	// Update the report descriptor for the axes if new data is available from
 	// the sensor.
@@ -253,19 +379,45 @@ static uchar mouse_update_axes() {  // {{{
 	FIX_POINTER(sens);
 
 	if (sens->new_data_available && !sens->overflow) {
+		uchar converted;
+
 		// Marking the data as "used"
 		sens->new_data_available = 0;
 
 		// Trying to convert the coordinates
-		if (
+		PROFILE_BEGIN(PROJECTION);
+		converted =
 			//mouse_axes_no_conversion()
-			mouse_axes_linear_equation_system()
-		) {
+			mouse_axes_linear_equation_system();
+		PROFILE_END(PROJECTION);
+
+		if (converted) {
+#if ENABLE_DIAGNOSTICS
+			mouse_position_ready = 1;
+#endif
+#if ENABLE_REPORT_TIMESTAMPS
+			mouse_report.sample_timestamp = sens->timestamp;
+#endif
+#if ENABLE_DIGITIZER
+			mouse_report.in_range = 1;
+#endif
 			return 1;
 		} else {
 			// But sometimes it will fail
+#if ENABLE_DIGITIZER
+			// Not pointing at the screen. Only one report is needed to
+			// tell that to the computer.
+			return mouse_set_out_of_range();
+#else
 			return 0;
+#endif
 		}
+#if ENABLE_DIGITIZER
+	} else if (sens->new_data_available) {
+		// Overflow
+		sens->new_data_available = 0;
+		return mouse_set_out_of_range();
+#endif
 	} else {
 		// Clearing the x, y to invalid values.
 		// Invalid values should be ignored by USB host.
@@ -280,6 +432,9 @@ static uchar mouse_update_axes() {  // {{{
 		// If no data is available, I just leave the previous data in there.
 		//
 		// Note: Windows correctly ignores the invalid values.
+		//
+		// With ENABLE_DIGITIZER, the In Range bit is the proper way of
+		// telling "not pointing at the screen", see above.
 		return 0;
 	}
 
@@ -287,20 +442,174 @@ static uchar mouse_update_axes() {  // {{{
 }  // }}}
 
 
+#if ENABLE_REPORT_GATE
+static uchar mouse_report_gate(uchar axes_modified) {  // {{{
+	// Receives the return value of mouse_update_axes().
+	// Return 1 if the new position is different enough from the last sent
+	// one, or if too many positions have been suppressed in a row.
+	//
+	// While the user holds the device still, the smoothed position keeps
+	// changing by one or two units (or not at all), and sending all those
+	// reports is just a waste of USB bandwidth and of host CPU.
+
+	MouseGate *gate = &mouse_gate;
+	FIX_POINTER(gate);
+
+	int dx, dy;
+
+	if (!axes_modified) {
+		return 0;
+	}
+
+#if ENABLE_DIGITIZER
+	if (mouse_report.in_range != gate->in_range) {
+		return 1;
+	}
+#endif
+
+	dx = mouse_report.x - gate->x;
+	dy = mouse_report.y - gate->y;
+	if (   dx >  MOUSE_REPORT_THRESHOLD
+		|| dx < -MOUSE_REPORT_THRESHOLD
+		|| dy >  MOUSE_REPORT_THRESHOLD
+		|| dy < -MOUSE_REPORT_THRESHOLD
+	) {
+		return 1;
+	}
+
+	// Keep-alive
+	gate->suppressed++;
+	return (gate->suppressed >= MOUSE_REPORT_KEEPALIVE);
+}  // }}}
+#endif
+
+
+#if ENABLE_CLICK_REWIND
+static uchar mouse_click_rewind(uchar axes_modified, uchar pressed) {  // {{{
+	// Receives the return value of mouse_update_axes(), and the buttons that
+	// were pressed since the previous report. Must be called after
+	// mouse_update_buttons().
+	// Return 1 if the position in the report should be sent to the computer.
+	//
+	// Records the positions, and holds the report at the pre-click position
+	// while a button is held and the pointer has not moved much.
+
+	MouseHistory *hist = &mouse_history;
+	FIX_POINTER(hist);
+
+	int dx, dy;
+	uchar i;
+
+	if (axes_modified) {
+		i = hist->head;
+		hist->x[i] = mouse_report.x;
+		hist->y[i] = mouse_report.y;
+		hist->head = (i + 1) & (MOUSE_HISTORY_SIZE - 1);
+		if (hist->samples < MOUSE_REWIND_SAMPLES) {
+			hist->samples++;
+		}
+	}
+
+	if (!hist->holding) {
+		// button.changed can't be used here, because it only lasts one
+		// iteration of the main loop, and this function is not called at
+		// every iteration.
+		if (!pressed || !hist->samples) {
+			return axes_modified;
+		}
+
+		// A button has just been pressed. Rewinding to the oldest of the
+		// recorded positions, from head-1 back to head-samples.
+		i = (hist->head - hist->samples) & (MOUSE_HISTORY_SIZE - 1);
+		hist->click_x = hist->x[i];
+		hist->click_y = hist->y[i];
+		hist->holding = 1;
+		axes_modified = 1;
+	} else if (!(button.state & 0x07)) {
+		// All buttons released. This report still carries the clicked
+		// position, the next one follows the sensor.
+		hist->holding = 0;
+	} else if (axes_modified) {
+		dx = mouse_report.x - hist->click_x;
+		dy = mouse_report.y - hist->click_y;
+		if (   dx >  MOUSE_DRAG_THRESHOLD
+			|| dx < -MOUSE_DRAG_THRESHOLD
+			|| dy >  MOUSE_DRAG_THRESHOLD
+			|| dy < -MOUSE_DRAG_THRESHOLD
+		) {
+			// Dragging
+			hist->holding = 0;
+			return 1;
+		}
+		axes_modified = 0;
+	}
+
+	mouse_report.x = hist->click_x;
+	mouse_report.y = hist->click_y;
+	return axes_modified;
+}  // }}}
+#endif
+
+
 uchar mouse_prepare_next_report() {  // {{{
 	// Return 1 if a new report is available and should be sent to the
 	// computer.
 
+	uchar modified;
+
+#if ENABLE_RAM_OVERLAY
+	mode_overlay_claim(OVERLAY_MOUSE);
+#endif
+
+#if ENABLE_CLICK_REWIND
+	uchar axes_modified;
+	uchar old_buttons = mouse_report.buttons;
+
+	modified = mouse_update_buttons();
+	axes_modified = mouse_click_rewind(mouse_update_axes(), mouse_report.buttons & ~old_buttons);
+#if ENABLE_REPORT_GATE
+	modified |= mouse_report_gate(axes_modified);
+#else
+	modified |= axes_modified;
+#endif
+#else
 	if (button.recent_state_change) {
 		// Don't try to update the pointer coordinates after a click.
-		return mouse_update_buttons();
+		modified = mouse_update_buttons();
 	} else {
 		// I'm using a bitwise OR here because a boolean OR would short-circuit
 		// the expression and wouldn't run the second function. It's ugly, but
 		// it's simple and works.
-		return mouse_update_buttons() | mouse_update_axes();
+#if ENABLE_REPORT_GATE
+		modified = mouse_update_buttons() | mouse_report_gate(mouse_update_axes());
+#else
+		modified = mouse_update_buttons() | mouse_update_axes();
+#endif
+	}
+#endif
+
+#if ENABLE_REPORT_GATE
+	if (modified) {
+		// Remembering what is being sent
+		mouse_gate.x = mouse_report.x;
+		mouse_gate.y = mouse_report.y;
+#if ENABLE_DIGITIZER
+		mouse_gate.in_range = mouse_report.in_range;
+#endif
+		mouse_gate.suppressed = 0;
 	}
+#endif
+
+#if ENABLE_REPORT_TIMESTAMPS
+	if (modified) {
+		mouse_report.sequence++;
+	}
+#endif
+
+	return modified;
 }  // }}}
 
+#endif  // ENABLE_HOST_PROJECTION
+
 
 // vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -8,18 +8,106 @@
 
 #include "common.h"
 #include "sensor.h"
+#include "hidreport.h"
 
 
+#if ENABLE_HOST_PROJECTION
+
+// Bit masks for VectorReport.flags
+#define VECTOR_FLAG_BUTTONS   0x07  // Same bits as button.state
+#define VECTOR_FLAG_OVERFLOW  0x08  // The sensor reported an overflow
+
+typedef struct VectorReport {
+	uchar report_id;
+	int x;  // Zero-compensated sensor data
+	int y;
+	int z;
+	uchar flags;
+} VectorReport;
+
+extern VectorReport vector_report;
+
+#else
+
+#if ENABLE_DIGITIZER
+// Type and maximum value of MouseReport.x and MouseReport.y
+#define MOUSE_AXIS_TYPE  unsigned int
+#define MOUSE_AXIS_MAX   65535
+#else
+#define MOUSE_AXIS_TYPE  int
+#define MOUSE_AXIS_MAX   32767
+#endif
+
 typedef struct MouseReport {
 	uchar report_id;
-	int x; // 0..32767
-	int y; // 0..32767
+	MOUSE_AXIS_TYPE x; // 0..MOUSE_AXIS_MAX
+	MOUSE_AXIS_TYPE y; // 0..MOUSE_AXIS_MAX
+#if ENABLE_DIGITIZER
+	uchar buttons:3;  // Tip, Barrel and Secondary Barrel switches
+	uchar in_range:1;  // Cleared if not pointing at the screen
+	uchar unused_bits:4;
+#elif ENABLE_REPORT_TIMESTAMPS
+	uchar buttons:3;
+	uchar sequence:5;  // Incremented at each new report
+	unsigned int sample_timestamp;  // clock_timestamp() of the sensor data
+#else
 	uchar buttons;
+#endif
 } MouseReport;
 
 extern MouseReport mouse_report;
 
 
+// State of the mouse emulation, only used in the mouse mode. The variables
+// are declared here because they may live in the RAM overlay (overlay.h).
+
+typedef struct SmoothingVars {
+	float first;
+	float second;
+} SmoothingVars;
+
+#if ENABLE_REPORT_GATE
+typedef struct MouseGate {
+	// Last sent position
+	MOUSE_AXIS_TYPE x;
+	MOUSE_AXIS_TYPE y;
+#if ENABLE_DIGITIZER
+	uchar in_range;
+#endif
+	// How many positions have been suppressed since the last report
+	uchar suppressed;
+} MouseGate;
+#endif
+
+#if ENABLE_CLICK_REWIND
+// Must be a power of 2, and at least MOUSE_REWIND_SAMPLES
+#define MOUSE_HISTORY_SIZE 8
+
+typedef struct MouseHistory {
+	// Ring buffer of the latest positions, "head" is the next to be written
+	MOUSE_AXIS_TYPE x[MOUSE_HISTORY_SIZE];
+	MOUSE_AXIS_TYPE y[MOUSE_HISTORY_SIZE];
+	uchar head;
+	// How many valid positions are in the buffer, up to MOUSE_REWIND_SAMPLES
+	uchar samples;
+
+	// While set, the report is held at the clicked position
+	uchar holding;
+	MOUSE_AXIS_TYPE click_x;
+	MOUSE_AXIS_TYPE click_y;
+} MouseHistory;
+#endif
+
+#endif
+
+
+#if ENABLE_DIAGNOSTICS
+// Set once the report carries a position from a sensor sample. Until then,
+// the reports only carry the buttons. Used for DIAG_FIRST_REPORT.
+extern uchar mouse_position_ready;
+#endif
+
+
 void init_mouse_emulation();
 uchar mouse_prepare_next_report();
 
@@ -0,0 +1,42 @@
+/* Name: overlay.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * The menu and the mouse emulation are never active at the same time, so
+ * the variables used by only one of them share the same RAM, which is
+ * mode_overlay. Whoever is about to use it must call mode_overlay_claim()
+ * first. The variables of the other mode are lost, and the new owner starts
+ * with all variables at zero, just like after power-on.
+ *
+ * The variables keep their names, redefined as macros at overlay.h, so any
+ * file that uses them must include overlay.h.
+ */
+
+
+#include <string.h>
+
+#include "common.h"
+#include "overlay.h"
+
+
+#if ENABLE_RAM_OVERLAY
+
+ModeOverlay mode_overlay;
+
+static uchar mode_overlay_owner = OVERLAY_NONE;
+
+
+void mode_overlay_claim(uchar owner) {  // {{{
+	if (mode_overlay_owner != owner) {
+		memset(&mode_overlay, 0, sizeof(mode_overlay));
+		mode_overlay_owner = owner;
+	}
+}  // }}}
+
+#endif  // ENABLE_RAM_OVERLAY
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
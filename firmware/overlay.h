@@ -0,0 +1,69 @@
+/* Name: overlay.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __overlay_h_included__
+#define __overlay_h_included__
+
+#include "common.h"
+
+#if ENABLE_RAM_OVERLAY
+
+#include "keyemu.h"
+#include "mouseemu.h"
+#include "sensor.h"
+
+#if !ENABLE_KEYBOARD || !ENABLE_MOUSE || ENABLE_HOST_PROJECTION
+#error "ENABLE_RAM_OVERLAY needs both the menu (keyboard) and the mouse modes"
+#endif
+
+
+// Values of mode_overlay_owner
+#define OVERLAY_NONE   0
+#define OVERLAY_MENU   1
+#define OVERLAY_MOUSE  2
+
+// Variables only used while the menu is active
+typedef struct MenuOverlay {
+	// Shared output buffer, see keyemu.h
+	uchar string_output_buffer[STRING_OUTPUT_BUFFER_SIZE];
+
+	// Zero calibration temporary values
+	XYZVector zero_min;
+	XYZVector zero_max;
+} MenuOverlay;
+
+// Variables only used while emulating the mouse, see mouseemu.c
+typedef struct MouseOverlay {
+	SmoothingVars smooth[2];
+#if ENABLE_REPORT_GATE
+	MouseGate gate;
+#endif
+#if ENABLE_CLICK_REWIND
+	MouseHistory history;
+#endif
+} MouseOverlay;
+
+typedef union ModeOverlay {
+	MenuOverlay menu;
+	MouseOverlay mouse;
+} ModeOverlay;
+
+extern ModeOverlay mode_overlay;
+
+void mode_overlay_claim(uchar owner);
+
+
+// The variables keep their usual names
+#define string_output_buffer (mode_overlay.menu.string_output_buffer)
+#define mouse_smooth         (mode_overlay.mouse.smooth)
+#define mouse_gate           (mode_overlay.mouse.gate)
+#define mouse_history        (mode_overlay.mouse.history)
+
+#endif  // ENABLE_RAM_OVERLAY
+
+
+#endif  // __overlay_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,230 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Compresses the menu strings for ENABLE_PACKED_STRINGS.
+#
+# Reads menu.c, already run through the preprocessor with
+# -DPACKED_STRINGS_EXTRACT (see the Makefile), and writes packed_strings.h
+# to stdout:
+#   avr-gcc -E $(CFLAGS) -DPACKED_STRINGS_EXTRACT menu.c | ./pack_strings.py > packed_strings.h
+#
+# Running after the preprocessor means that only the strings of the current
+# configuration (ENABLE_FULL_MENU and friends) are packed.
+#
+# The compression is a simple dictionary: the most repeated substrings
+# (" Print ", " << back\n", " Set "...) are stored once, and replaced by a
+# single byte from 0x80 to 0xFF. The dictionary entries are plain ASCII,
+# so the decoder at keyemu.c is just a lookup.
+#
+# Offsets given by PACKED_OFFSET() are kept at the start of a code, and
+# become "#define name_at_offset packed_offset".
+
+from __future__ import division
+from __future__ import print_function
+
+import ast
+import re
+import sys
+
+
+FIRST_CODE = 0x80
+MAX_CODES = 0x100 - FIRST_CODE
+
+# Longer candidates are very unlikely to repeat
+MAX_ENTRY_LENGTH = 24
+
+
+STRING_RE = re.compile(r'PACKED_STRING_MARKER\s+(\w+)\s+((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL_RE = re.compile(r'"(?:[^"\\]|\\.)*"')
+OFFSET_RE = re.compile(r'PACKED_OFFSET_MARKER\s+(\w+)\s+(\d+)')
+
+
+def parse_input(text):
+    # Returns a list of (name, string) and a dict of name -> set of offsets.
+    strings = []
+    for match in STRING_RE.finditer(text):
+        name = match.group(1)
+        # Adjacent literals are concatenated, as in C.
+        # The C escapes used in the menu (\n, \t, \\, \") are the same in
+        # Python.
+        value = ''.join(
+            ast.literal_eval(literal)
+            for literal in LITERAL_RE.findall(match.group(2))
+        )
+        for c in value:
+            if ord(c) >= FIRST_CODE:
+                sys.exit('{0}: non-ASCII characters cannot be packed'.format(name))
+        strings.append((name, value))
+
+    offsets = {}
+    for match in OFFSET_RE.finditer(text):
+        offsets.setdefault(match.group(1), set()).add(int(match.group(2)))
+
+    names = set(name for name, value in strings)
+    for name in offsets:
+        if name not in names:
+            sys.exit('PACKED_OFFSET() of unknown string {0}'.format(name))
+
+    return strings, offsets
+
+
+def split_pieces(strings, offsets):
+    # Splits each string at its offsets, so that no dictionary entry goes
+    # across them. Each piece is a list of tokens, either a char (str) or a
+    # dictionary code (int).
+    pieces = []
+    for name, value in strings:
+        cuts = sorted(set([0, len(value)]) | offsets.get(name, set()))
+        for start, end in zip(cuts, cuts[1:]):
+            pieces.append(list(value[start:end]))
+    return pieces
+
+
+def count_candidates(pieces):
+    # Counts non-overlapping occurrences of each run of plain chars.
+    counts = {}
+    last_end = {}
+    for index, piece in enumerate(pieces):
+        length = len(piece)
+        for start in range(length):
+            for end in range(start + 2, min(start + MAX_ENTRY_LENGTH, length) + 1):
+                if not isinstance(piece[end - 1], str):
+                    break
+                if not isinstance(piece[start], str):
+                    break
+                candidate = ''.join(piece[start:end])
+                if last_end.get(candidate, (-1, 0)) > (index, start):
+                    # Overlaps the previous occurrence
+                    continue
+                last_end[candidate] = (index, end)
+                counts[candidate] = counts.get(candidate, 0) + 1
+    return counts
+
+
+def replace(pieces, entry, code):
+    n = len(entry)
+    for piece in pieces:
+        i = 0
+        while i + n <= len(piece):
+            if all(isinstance(t, str) for t in piece[i:i + n]) and ''.join(piece[i:i + n]) == entry:
+                piece[i:i + n] = [code]
+            i += 1
+
+
+def build_dictionary(pieces):
+    dictionary = []
+    while len(dictionary) < MAX_CODES:
+        best = None
+        best_saving = 0
+        for candidate, count in count_candidates(pieces).items():
+            # Each occurrence saves len-1 bytes, the entry itself costs len+1
+            saving = count * (len(candidate) - 1) - (len(candidate) + 1)
+            if saving > best_saving or (saving == best_saving and best is not None and candidate < best):
+                best = candidate
+                best_saving = saving
+        if best is None:
+            break
+        replace(pieces, best, FIRST_CODE + len(dictionary))
+        dictionary.append(best)
+    return dictionary
+
+
+def encode(value, dictionary, cuts):
+    # Greedy encoding of a single string, using the longest entry at each
+    # position, never crossing the cuts. Returns the bytes and a map of
+    # original offset -> packed offset.
+    out = []
+    positions = {}
+    i = 0
+    while i < len(value):
+        positions[i] = len(out)
+        limit = min([c for c in cuts if c > i] + [len(value)])
+        best = None
+        for code, entry in enumerate(dictionary):
+            if value.startswith(entry, i) and i + len(entry) <= limit:
+                if best is None or len(entry) > len(dictionary[best]):
+                    best = code
+        if best is None:
+            out.append(ord(value[i]))
+            i += 1
+        else:
+            out.append(FIRST_CODE + best)
+            i += len(dictionary[best])
+    positions[i] = len(out)
+    out.append(0)
+    return out, positions
+
+
+def c_escape(value):
+    return value.replace('\\', '\\\\').replace('\n', '\\n').replace('\t', '\\t').replace('"', '\\"')
+
+
+def format_bytes(data, indent):
+    lines = []
+    for i in range(0, len(data), 12):
+        lines.append(indent + ', '.join('0x{0:02X}'.format(b) for b in data[i:i + 12]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    strings, offsets = parse_input(sys.stdin.read())
+
+    dictionary = build_dictionary(split_pieces(strings, offsets))
+
+    out = []
+    out.append('/* Name: packed_strings.h')
+    out.append(' *')
+    out.append(' * Generated by pack_strings.py, do not edit.')
+    out.append(' */')
+    out.append('')
+    out.append('#ifndef __packed_strings_h_included__')
+    out.append('#define __packed_strings_h_included__')
+    out.append('')
+    out.append('')
+
+    out.append('// Dictionary, code 0x{0:02X} is the first entry'.format(FIRST_CODE))
+    for code, entry in enumerate(dictionary):
+        out.append('// 0x{0:02X} "{1}"'.format(FIRST_CODE + code, c_escape(entry)))
+    dict_bytes = []
+    for entry in dictionary:
+        dict_bytes.extend(ord(c) for c in entry)
+        dict_bytes.append(0)
+    out.append('const uchar packed_strings_dictionary[] PROGMEM = {')
+    if dict_bytes:
+        out.append(format_bytes(dict_bytes, '\t'))
+    else:
+        out.append('\t0')
+    out.append('};')
+    out.append('')
+
+    original_size = 0
+    packed_size = len(dict_bytes)
+    for name, value in strings:
+        cuts = offsets.get(name, set())
+        data, positions = encode(value, dictionary, cuts)
+        original_size += len(value) + 1
+        packed_size += len(data)
+
+        out.append('// "{0}"'.format(c_escape(value)))
+        out.append('static const char {0}[] PROGMEM = {{'.format(name))
+        out.append(format_bytes(data, '\t'))
+        out.append('};')
+        for offset in sorted(cuts):
+            out.append('#define {0}_at_{1} {2}'.format(name, offset, positions[offset]))
+
+    out.append('')
+    out.append('')
+    out.append('#endif  // __packed_strings_h_included____')
+    print('\n'.join(out))
+
+    print(
+        'pack_strings.py: {0} strings, {1} bytes packed into {2} bytes ({3} dictionary entries)'.format(
+            len(strings), original_size, packed_size, len(dictionary)
+        ),
+        file=sys.stderr
+    )
+
+
+if __name__ == '__main__':
+    main()
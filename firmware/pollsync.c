@@ -0,0 +1,160 @@
+/* Name: pollsync.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Synchronizes the sensor readings with the USB host polling.
+ *
+ * The host polls the interrupt endpoint at a fixed interval (10ms is
+ * requested at usbconfig.h, but Linux uses 8ms for low-speed devices). In
+ * the default mode, the sensor runs in continuous mode at 75Hz and is read
+ * every 5 Timer0 ticks, completely unrelated to the host polling, so the
+ * sample inside each report can be anywhere between fresh and one poll
+ * interval old.
+ *
+ * In this mode, the firmware watches usbInterruptIsReady(). It goes from 0
+ * to 1 right after the host has taken the previous report, which tells
+ * both the phase and (after a few polls) the period of the host polling.
+ * The sensor is then put in single-measurement mode, and each measurement
+ * is started POLLSYNC_LEAD_TIME before the next expected poll. When it
+ * finishes, the data is read, the mouse report is built and queued by the
+ * main loop, and the host takes it shortly after.
+ *
+ * If USB_COUNT_SOF is enabled, the number of USB frames between two polls
+ * gives the exact polling interval, instead of an average of the measured
+ * intervals. However, that requires the USB interrupt to be on D- (and thus
+ * rewiring, see the hardware description at main.c), as explained in
+ * usbconfig.h.
+ *
+ * If the host stops polling (or nothing is being sent), the measurements
+ * keep being done at the estimated period.
+ */
+
+
+#include "usbdrv.h"
+
+#include "clock.h"
+#include "pollsync.h"
+#include "sensor.h"
+
+
+#if ENABLE_POLL_SYNC
+
+PollSync pollsync;
+
+
+////////////////////////////////////////////////////////////
+// Timing constants                                      {{{
+
+// According to the HMC5883L datasheet, a single measurement takes about
+// 6ms.
+#define POLLSYNC_MEASUREMENT_TIME  CLOCK_MS(6)
+
+// How much time before the next poll a measurement should be started.
+// This includes the measurement itself, reading the data over I2C (about
+// 0.2ms at 400KHz) and converting it to screen coordinates.
+#define POLLSYNC_LEAD_TIME  (POLLSYNC_MEASUREMENT_TIME + CLOCK_MS(2))
+
+#if USB_COUNT_SOF
+// Duration of one USB frame (1ms)
+#define POLLSYNC_FRAME_TIME  CLOCK_MS(1)
+#endif
+
+// }}}
+
+
+void pollsync_observe_poll() {  // {{{
+	// Must be called at every iteration of the main loop, after the
+	// usbSetInterrupt() calls.
+
+	PollSync *ps = &pollsync;
+	FIX_POINTER(ps);
+
+	uchar ready;
+	unsigned int now;
+	unsigned int interval;
+
+	if (!sensor.continuous_reading) {
+		ps->step = POLLSYNC_STOPPED;
+	}
+
+	ready = usbInterruptIsReady();
+	if (ready && !ps->was_ready) {
+		// The host has just taken the report.
+		now = clock_timestamp();
+
+#if USB_COUNT_SOF
+		interval = (uchar)(usbSofCount - ps->last_sof) * POLLSYNC_FRAME_TIME;
+		ps->last_sof = usbSofCount;
+#else
+		interval = now - ps->last_poll;
+#endif
+
+		// If the endpoint was not busy during one or more polls, the interval
+		// will be a multiple of the period. Those are ignored.
+		if (interval > ps->period / 2 && interval < ps->period + ps->period / 2) {
+#if USB_COUNT_SOF
+			// Already exact
+			ps->period = interval;
+#else
+			// Exponential moving average, with alpha = 1/8
+			ps->period += ((int)(interval - ps->period)) / 8;
+#endif
+		}
+
+		ps->last_poll = now;
+		ps->next_poll = now + ps->period;
+	}
+	ps->was_ready = ready;
+}  // }}}
+
+
+void pollsync_read_sensor() {  // {{{
+	// Replaces the Timer0-based reading of the sensor.
+	// Should be called at every iteration of the main loop, while
+	// sensor.continuous_reading is set.
+	//
+	// This function is non-blocking.
+
+	PollSync *ps = &pollsync;
+	FIX_POINTER(ps);
+
+	unsigned int now;
+	uchar return_code;
+
+	now = clock_timestamp();
+
+	switch (ps->step) {
+		case POLLSYNC_STOPPED:
+			// The reading has just been (re)started, the last known poll
+			// may be too old.
+			ps->next_poll = now;
+			ps->step = POLLSYNC_WAITING_TRIGGER;
+		case POLLSYNC_WAITING_TRIGGER:
+			if ((int)(now - (ps->next_poll - POLLSYNC_LEAD_TIME)) < 0) return;
+			if (sensor_start_single_measurement() != SENSOR_FUNC_DONE) return;
+
+			ps->trigger_time = now;
+			ps->step = POLLSYNC_MEASURING;
+			return;
+		case POLLSYNC_MEASURING:
+			if (now - ps->trigger_time < POLLSYNC_MEASUREMENT_TIME) return;
+
+			ps->step = POLLSYNC_READING;
+		case POLLSYNC_READING:
+			return_code = sensor_read_data_registers();
+			if (return_code == SENSOR_FUNC_STILL_WORKING) return;
+
+			// Next measurement is for the next poll. If the host polls, the
+			// expected time is updated by pollsync_observe_poll().
+			ps->next_poll += ps->period;
+			ps->step = POLLSYNC_WAITING_TRIGGER;
+	}
+}  // }}}
+
+#endif  // ENABLE_POLL_SYNC
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
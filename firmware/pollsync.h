@@ -0,0 +1,58 @@
+/* Name: pollsync.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __pollsync_h_included__
+#define __pollsync_h_included__
+
+#include "clock.h"
+#include "common.h"
+
+
+// Used until the actual polling interval has been measured
+#define POLLSYNC_DEFAULT_PERIOD CLOCK_MS(USB_CFG_INTR_POLL_INTERVAL)
+
+
+// Values for PollSync.step
+#define POLLSYNC_STOPPED           0
+#define POLLSYNC_WAITING_TRIGGER   1
+#define POLLSYNC_MEASURING         2
+#define POLLSYNC_READING           3
+
+
+typedef struct PollSync {
+	// Current step of pollsync_read_sensor()
+	uchar step;
+
+	// Last value of usbInterruptIsReady()
+	uchar was_ready;
+
+#if USB_COUNT_SOF
+	// Value of usbSofCount at the last observed poll
+	uchar last_sof;
+#endif
+
+	// All times are clock_timestamp() values.
+	// When the host has last taken a report from the interrupt endpoint
+	unsigned int last_poll;
+	// When the host is expected to poll again
+	unsigned int next_poll;
+	// Estimated polling interval
+	unsigned int period;
+	// When the current sensor measurement has been started
+	unsigned int trigger_time;
+} PollSync;
+
+extern PollSync pollsync;
+
+
+#define init_pollsync() do{ pollsync.period = POLLSYNC_DEFAULT_PERIOD; }while(0)
+
+void pollsync_observe_poll();
+void pollsync_read_sensor();
+
+
+#endif  // __pollsync_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,76 @@
+/* Name: profiling.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Cycle counting of the main loop stages, for finding out where the time
+ * is spent.
+ *
+ * Each stage is surrounded by PROFILE_BEGIN() and PROFILE_END(), which read
+ * TCNT1 (Timer1 running at the CPU clock). The minimum, maximum and total
+ * number of cycles are stored for each stage, together with a histogram of
+ * the duration of each main loop iteration.
+ *
+ * Everything is kept in a HID feature report (ID 4), which can be read at
+ * any time with host_tools/profile_dump.py. The numbers include the time
+ * spent inside interrupts (mostly V-USB), and about 50 cycles of overhead
+ * of profile_record() itself.
+ *
+ * When ENABLE_PROFILING is 0, all of this is compiled out.
+ */
+
+
+#include <avr/io.h>
+
+#include "profiling.h"
+
+
+#if ENABLE_PROFILING
+
+ProfilingReport profiling_report;
+
+static unsigned int profile_last_loop;
+
+
+void profile_record(uchar stage, unsigned int cycles) {  // {{{
+	ProfileStage *s = &profiling_report.stages[stage];
+	FIX_POINTER(s);
+
+	if (s->count == 0 || cycles < s->min) {
+		s->min = cycles;
+	}
+	if (cycles > s->max) {
+		s->max = cycles;
+	}
+	s->total += cycles;
+	s->count++;
+}  // }}}
+
+
+void profile_loop_iteration() {  // {{{
+	// Must be called at the beginning of each iteration of the main loop.
+
+	unsigned int now;
+	unsigned int cycles;
+	unsigned int limit;
+	uchar bin;
+
+	now = TCNT1;
+	cycles = now - profile_last_loop;
+	profile_last_loop = now;
+
+	bin = 0;
+	limit = 512;
+	while (bin < PROFILE_LOOP_BINS - 1 && cycles >= limit) {
+		bin++;
+		limit <<= 1;
+	}
+	profiling_report.loop_histogram[bin]++;
+}  // }}}
+
+#endif  // ENABLE_PROFILING
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
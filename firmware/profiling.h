@@ -0,0 +1,76 @@
+/* Name: profiling.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __profiling_h_included__
+#define __profiling_h_included__
+
+#include <avr/io.h>
+#include "common.h"
+#include "hidreport.h"
+#include "scheduler.h"
+
+
+// Stages of the main loop
+// If changed, remember to update STAGE_NAMES at host_tools/profile_dump.py
+#define PROFILE_USBPOLL     0
+#define PROFILE_BUTTONS     1
+#define PROFILE_SENSOR      2
+#define PROFILE_PROJECTION  3
+#define PROFILE_MENU        4
+#define PROFILE_REPORT      5
+#define PROFILE_SLEEP       6
+#define PROFILE_TOTAL_STAGES 7
+
+// Number of bins in the loop-iteration histogram.
+// Bin 0 counts iterations shorter than 512 cycles, and each following bin
+// doubles the limit. The last bin counts everything else.
+#define PROFILE_LOOP_BINS   8
+
+
+#if ENABLE_PROFILING
+
+typedef struct ProfileStage {
+	// All values are in CPU cycles
+	unsigned int min;
+	unsigned int max;
+	unsigned long total;
+	unsigned long count;
+} ProfileStage;
+
+typedef struct ProfilingReport {
+	uchar report_id;
+	ProfileStage stages[PROFILE_TOTAL_STAGES];
+	unsigned long loop_histogram[PROFILE_LOOP_BINS];
+	// Copied from the scheduler when this report is read. All zero without
+	// ENABLE_SCHEDULER.
+	SchedulerStats scheduler;
+} ProfilingReport;
+
+extern ProfilingReport profiling_report;
+
+
+// Timer1 runs at the CPU clock (configured at hardware_init()), so
+// TCNT1 is a cycle counter that wraps around every 65536 cycles (5.46ms).
+// Longer stages will be measured wrong.
+#define PROFILE_BEGIN(stage) unsigned int profile_start_##stage = TCNT1
+#define PROFILE_END(stage)   profile_record(PROFILE_##stage, TCNT1 - profile_start_##stage)
+
+#define init_profiling() do{ profiling_report.report_id = PROFILE_REPORT_ID; }while(0)
+
+void profile_record(uchar stage, unsigned int cycles);
+void profile_loop_iteration();
+
+#else
+
+// Compiled out
+#define PROFILE_BEGIN(stage) do{ }while(0)
+#define PROFILE_END(stage)   do{ }while(0)
+
+#endif
+
+
+#endif  // __profiling_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
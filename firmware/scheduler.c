@@ -0,0 +1,140 @@
+/* Name: scheduler.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Small table-driven cooperative scheduler.
+ *
+ * The tasks are listed in scheduler_tasks[] (at main.c), each one with its
+ * own period, so there is no need to derive everything from a single
+ * "timer_overflow" flag and hand-tuned countdown counters.
+ *
+ * All times come from clock_timestamp(), which wraps around every 349.5ms.
+ * Thus, periods and deadlines must be well below that. The Timer0 overflow
+ * interrupt is enabled with the scheduler (see clock.c), so that
+ * clock_timestamp() keeps counting during long iterations of the main loop.
+ *
+ * With ENABLE_PROFILING, the scheduler also keeps some statistics: the
+ * longest run of each task, how many times each task has started late or
+ * has taken longer than its budget, and the longest interval between two
+ * usbPoll() calls (which gives the slack before V-USB gets in trouble).
+ * They are sent in the profiling report, see host_tools/profile_dump.py.
+ */
+
+
+#include <avr/pgmspace.h>
+
+#include "clock.h"
+#include "scheduler.h"
+
+
+#if ENABLE_SCHEDULER
+
+SchedulerState scheduler;
+
+
+void scheduler_init() {  // {{{
+	// Must be called right before the main loop.
+
+	SchedulerState *sched = &scheduler;
+	FIX_POINTER(sched);
+
+	unsigned int now;
+	uchar i;
+
+	now = clock_timestamp();
+
+	for (i = 0; i < SCHEDULER_TOTAL_TASKS; i++) {
+		sched->tasks[i].next_run = now;
+	}
+#if ENABLE_PROFILING
+	sched->last_usbpoll = now;
+#endif
+}  // }}}
+
+
+#if ENABLE_PROFILING
+void scheduler_usbpoll_called() {  // {{{
+	// Must be called right after usbPoll().
+
+	SchedulerState *sched = &scheduler;
+	FIX_POINTER(sched);
+
+	unsigned int now;
+	unsigned int interval;
+
+	now = clock_timestamp();
+	interval = now - sched->last_usbpoll;
+	if (interval > sched->stats.max_usbpoll_interval) {
+		sched->stats.max_usbpoll_interval = interval;
+	}
+	sched->last_usbpoll = now;
+}  // }}}
+#endif
+
+
+void scheduler_run() {  // {{{
+	// Must be called at every iteration of the main loop.
+	// Runs all tasks that are due (or that have yielded).
+
+	SchedulerState *sched = &scheduler;
+	FIX_POINTER(sched);
+
+	uchar i;
+
+	for (i = 0; i < SCHEDULER_TOTAL_TASKS; i++) {
+		SchedulerTaskState *state = &sched->tasks[i];
+		const SchedulerTask *task = &scheduler_tasks[i];
+		uchar (*run)(void);
+		unsigned int start;
+		unsigned int period;
+#if ENABLE_PROFILING
+		SchedulerTaskStats *stats = &sched->stats.tasks[i];
+		unsigned int runtime;
+#endif
+
+		start = clock_timestamp();
+
+		if (!state->running) {
+			if ((int)(start - state->next_run) < 0) {
+				// Not yet
+				continue;
+			}
+
+#if ENABLE_PROFILING
+			if (start - state->next_run > pgm_read_word(&task->deadline)) {
+				if (stats->deadline_misses < 255) stats->deadline_misses++;
+			}
+#endif
+
+			// Scheduling the next run. If the task is so late that it has
+			// already missed the next run, there is no point in running it
+			// several times in a row to catch up.
+			period = pgm_read_word(&task->period);
+			state->next_run += period;
+			if ((int)(start - state->next_run) >= 0) {
+				state->next_run = start + period;
+			}
+		}
+
+		run = (void*) pgm_read_word(&task->run);
+		state->running = (run() == SCHEDULER_TASK_YIELD);
+
+#if ENABLE_PROFILING
+		runtime = clock_timestamp() - start;
+		if (runtime > stats->max_runtime) {
+			stats->max_runtime = runtime;
+		}
+		if (runtime > pgm_read_word(&task->budget)) {
+			if (stats->budget_overruns < 255) stats->budget_overruns++;
+		}
+#endif
+	}
+}  // }}}
+
+#endif  // ENABLE_SCHEDULER
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
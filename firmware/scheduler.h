@@ -0,0 +1,99 @@
+/* Name: scheduler.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __scheduler_h_included__
+#define __scheduler_h_included__
+
+#include <avr/pgmspace.h>
+#include "clock.h"
+#include "common.h"
+
+
+// Number of entries in scheduler_tasks[] (checked at main.c)
+#define SCHEDULER_TOTAL_TASKS 2
+
+// One Timer0 overflow, in clock_timestamp() units
+#define SCHEDULER_TICK 256
+
+// V-USB requires usbPoll() to be called at least every 50ms, otherwise
+// SETUP packets from the host may time out.
+#define SCHEDULER_USBPOLL_DEADLINE CLOCK_MS(50)
+
+// Return values for SchedulerTask.run()
+#define SCHEDULER_TASK_YIELD 0
+#define SCHEDULER_TASK_DONE  1
+
+
+typedef struct SchedulerTask {
+	// Function that implements the task. It must not block. If it returns
+	// SCHEDULER_TASK_YIELD, it will be called again at the next iteration
+	// of the main loop, until it returns SCHEDULER_TASK_DONE.
+	uchar (*run)(void);
+
+	// All times are in clock_timestamp() units. Deadline and budget are
+	// only checked with ENABLE_PROFILING.
+	// Interval between the start of each run. Zero means "at every
+	// iteration of the main loop".
+	unsigned int period;
+	// How late a run can start before being counted as a deadline miss.
+	unsigned int deadline;
+	// How long a single call to run() can take before being counted as a
+	// budget overrun.
+	unsigned int budget;
+} SchedulerTask;
+
+typedef struct SchedulerTaskState {
+	// When this task should run again
+	unsigned int next_run;
+	// Non-zero if the task has yielded and must be called again
+	uchar running;
+} SchedulerTaskState;
+
+// Statistics, only kept with ENABLE_PROFILING, and sent to the computer in
+// the profiling report. All times are in clock_timestamp() units.
+typedef struct SchedulerTaskStats {
+	// Longest single call to run()
+	unsigned int max_runtime;
+	uchar deadline_misses;
+	uchar budget_overruns;
+} SchedulerTaskStats;
+
+typedef struct SchedulerStats {
+	SchedulerTaskStats tasks[SCHEDULER_TOTAL_TASKS];
+	// Longest interval between two usbPoll() calls. The host tool compares
+	// it with SCHEDULER_USBPOLL_DEADLINE.
+	unsigned int max_usbpoll_interval;
+} SchedulerStats;
+
+typedef struct SchedulerState {
+	SchedulerTaskState tasks[SCHEDULER_TOTAL_TASKS];
+
+#if ENABLE_PROFILING
+	// When usbPoll() has been called for the last time
+	unsigned int last_usbpoll;
+
+	SchedulerStats stats;
+#endif
+} SchedulerState;
+
+
+extern SchedulerState scheduler;
+// Defined at main.c, which checks that it has SCHEDULER_TOTAL_TASKS entries
+extern const SchedulerTask scheduler_tasks[] PROGMEM;
+
+
+void scheduler_init();
+void scheduler_run();
+
+#if ENABLE_PROFILING
+void scheduler_usbpoll_called();
+#else
+#define scheduler_usbpoll_called() do{ }while(0)
+#endif
+
+
+#endif  // __scheduler_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -14,6 +14,9 @@
 #include <avr/eeprom.h>
 
 #include "avr315/TWI_Master.h"
+#include "calstore.h"
+#include "clock.h"
+#include "diagnostics.h"
 #include "sensor.h"
 
 
@@ -176,6 +179,14 @@ uchar sensor_read_data_registers() {  // {{{
 	SensorData *sens = &sensor;
 	FIX_POINTER(sens);
 
+#if ENABLE_BUS_RECOVERY
+	if (sens->recovering) {
+		// Not touching the bus while busrecovery.c works on it
+		DIAGNOSTICS_COUNT(lost_samples);
+		return SENSOR_FUNC_ERROR;
+	}
+#endif
+
 	switch(sens->func_step) {
 		case 0:  // Set address pointer
 			if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
@@ -216,11 +227,23 @@ uchar sensor_read_data_registers() {  // {{{
 					sens->data.z -= sens->e.zero.z;
 				}
 
+#if ENABLE_REPORT_TIMESTAMPS
+				sens->timestamp = clock_timestamp();
+#endif
+
 				sens->new_data_available = 1;
 				sens->error_while_reading = 0;
+#if ENABLE_BUS_RECOVERY
+				sens->errors_in_a_row = 0;
+#endif
 				return SENSOR_FUNC_DONE;
 			} else {
 				sens->error_while_reading = 1;
+#if ENABLE_BUS_RECOVERY
+				if (sens->errors_in_a_row < 255) sens->errors_in_a_row++;
+#endif
+				DIAGNOSTICS_COUNT(twi_errors);
+				DIAGNOSTICS_COUNT(lost_samples);
 				return SENSOR_FUNC_ERROR;
 			}
 		default:
@@ -229,11 +252,59 @@ uchar sensor_read_data_registers() {  // {{{
 	}
 }  // }}}
 
+#if ENABLE_POLL_SYNC
+uchar sensor_start_single_measurement() {  // {{{
+	// Puts the sensor in single-measurement mode, which starts one
+	// measurement. After that, the sensor goes to idle mode.
+	// Used by pollsync.c, which takes care of the timing.
+	//
+	// This function is non-blocking.
+
+	if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
+#if ENABLE_BUS_RECOVERY
+	// Not touching the bus while busrecovery.c works on it
+	if (sensor.recovering) return SENSOR_FUNC_STILL_WORKING;
+#endif
+
+	sensor_set_register_value(SENSOR_REG_MODE, SENSOR_MODE_SINGLE);
+	return SENSOR_FUNC_DONE;
+}  // }}}
+#endif
+
+#if ENABLE_IDLE_SLEEP
+void sensor_set_idle(uchar idle) {  // {{{
+	// Puts the sensor in idle mode (it stops measuring, but still answers
+	// I2C), or back in continuous-measurement mode.
+	// Used by idlesleep.c during USB suspend.
+	//
+	// This function is non-blocking (except if TWI is already busy).
+
+#if ENABLE_BUS_RECOVERY
+	// Not touching the bus while busrecovery.c works on it. The recovery
+	// ends by putting the sensor in continuous mode.
+	if (sensor.recovering) return;
+#endif
+
+	sensor_set_register_value(
+		SENSOR_REG_MODE,
+		idle ? SENSOR_MODE_IDLE_A : SENSOR_MODE_CONTINUOUS
+	);
+}  // }}}
+#endif
+
 void sensor_start_continuous_reading() {  // {{{
 	SensorData *sens = &sensor;
 	FIX_POINTER(sens);
 
+#if ENABLE_BUS_RECOVERY
+	// While recovering, func_step belongs to the probe of sensor_startup(),
+	// and it is back at zero when the recovery ends.
+	if (!sens->recovering) {
+		sens->func_step = 0;
+	}
+#else
 	sens->func_step = 0;
+#endif
 	sens->new_data_available = 0;
 	sens->error_while_reading = 0;
 	sens->continuous_reading = 1;
@@ -243,7 +314,14 @@ void sensor_stop_continuous_reading() {  // {{{
 	SensorData *sens = &sensor;
 	FIX_POINTER(sens);
 
+#if ENABLE_BUS_RECOVERY
+	// Same as above
+	if (!sens->recovering) {
+		sens->func_step = 0;
+	}
+#else
 	sens->func_step = 0;
+#endif
 	//sens->new_data_available = 0;
 	//sens->error_while_reading = 0;
 	sens->continuous_reading = 0;
@@ -302,6 +380,120 @@ uchar sensor_read_identification_string(uchar *s) {  // {{{
 }  // }}}
 
 
+#if ENABLE_ASYNC_STARTUP || ENABLE_BUS_RECOVERY
+// The identification string is read up to this number of times, with
+// SENSOR_PROBE_INTERVAL between each try, before giving up.
+#define SENSOR_PROBE_ATTEMPTS  8
+#define SENSOR_PROBE_INTERVAL  CLOCK_MS(2)
+
+uchar sensor_startup() {  // {{{
+	// Non-blocking replacement for sensor_init_configuration(), to be
+	// called repeatedly while the USB reset and enumeration are going on.
+	// Loads the EEPROM data, probes the sensor by its identification
+	// string ("H43") and writes the configuration registers.
+	//
+	// Returns SENSOR_FUNC_DONE when the sensor has been configured, or
+	// SENSOR_FUNC_ERROR if it could not be found. In the latter case, the
+	// EEPROM data has been loaded anyway.
+	//
+	// This must be called AFTER interrupts were enabled and AFTER
+	// TWI_Master has been initialized.
+
+	SensorData *sens = &sensor;
+	FIX_POINTER(sens);
+
+	uchar id[4];
+	uchar return_code;
+
+	switch (sens->startup_step) {
+		case 0:  // Reading from the EEPROM
+			// Reading is fast, only writing would need waiting.
+#if ENABLE_CALIBRATION_STORE
+			calstore_load();
+#else
+			eeprom_read_block(&sens->e, &eeprom_sensor, sizeof(SensorEepromData));
+#endif
+			sens->probe_time = clock_timestamp();
+			sens->startup_step = 1;
+		case 1:  // Probing the sensor
+			if ((int)(clock_timestamp() - sens->probe_time) < 0) {
+				return SENSOR_FUNC_STILL_WORKING;
+			}
+
+			return_code = sensor_read_identification_string(id);
+			if (return_code == SENSOR_FUNC_STILL_WORKING) {
+				return SENSOR_FUNC_STILL_WORKING;
+			}
+
+			sens->probe_attempts++;
+			if (return_code != SENSOR_FUNC_DONE
+			|| id[0] != 'H' || id[1] != '4' || id[2] != '3') {
+				if (sens->probe_attempts >= SENSOR_PROBE_ATTEMPTS) {
+					// Giving up
+					sens->startup_step = 6;
+					return SENSOR_FUNC_ERROR;
+				}
+				sens->probe_time = clock_timestamp() + SENSOR_PROBE_INTERVAL;
+				return SENSOR_FUNC_STILL_WORKING;
+			}
+
+			sens->startup_step = 2;
+		case 2:
+			if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
+			sensor_set_register_value(
+				SENSOR_REG_CONF_A,
+				SENSOR_CONF_A_SAMPLES_8
+				| SENSOR_CONF_A_RATE_75
+				| SENSOR_CONF_A_BIAS_NORMAL
+			);
+			sens->startup_step = 3;
+		case 3:
+			if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
+			sensor_set_register_value(
+				SENSOR_REG_CONF_B,
+				SENSOR_CONF_B_GAIN_1_3
+			);
+			sens->startup_step = 4;
+		case 4:
+			if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
+			sensor_set_register_value(
+				SENSOR_REG_MODE,
+				SENSOR_MODE_CONTINUOUS
+			);
+			sens->startup_step = 5;
+		case 5:
+			// Waiting for the last write, so that the caller can use the
+			// sensor right away.
+			if (TWI_Transceiver_Busy()) return SENSOR_FUNC_STILL_WORKING;
+			if (TWI_statusReg.lastTransOK) {
+				return SENSOR_FUNC_DONE;
+			} else {
+				return SENSOR_FUNC_ERROR;
+			}
+		default:
+			return SENSOR_FUNC_ERROR;
+	}
+}  // }}}
+#endif
+
+#if ENABLE_BUS_RECOVERY
+void sensor_restart() {  // {{{
+	// Makes sensor_startup() probe and configure the sensor again (the
+	// EEPROM data is already in RAM). Also aborts any half-done reading.
+	// Used by busrecovery.c after the sensor has stopped answering, which
+	// usually means it has been power-cycled and lost its configuration.
+
+	SensorData *sens = &sensor;
+	FIX_POINTER(sens);
+
+	sens->func_step = 0;
+	sens->startup_step = 1;
+	sens->probe_attempts = 0;
+	sens->probe_time = clock_timestamp();
+}  // }}}
+#endif
+
+
 void sensor_init_configuration() {  // {{{
 	// This must be called AFTER interrupts were enabled and AFTER
 	// TWI_Master has been initialized.
@@ -313,7 +505,11 @@ void sensor_init_configuration() {  // {{{
 	//sensor.error_while_reading = 0;
 
 	// Reading from the EEPROM:
+#if ENABLE_CALIBRATION_STORE
+	calstore_load();
+#else
 	eeprom_read_block(&sensor.e, &eeprom_sensor, sizeof(SensorEepromData));
+#endif
 
 	sensor_set_register_value(
 		SENSOR_REG_CONF_A,
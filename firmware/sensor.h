@@ -60,23 +60,51 @@ typedef struct SensorData {
 			// should be called.
 			uchar continuous_reading:1;
 
+#if ENABLE_BUS_RECOVERY
+			// Set while busrecovery.c is recovering the bus or
+			// reconfiguring the sensor. No reading is done meanwhile.
+			uchar recovering:1;
+
+			uchar unused_bits:3;
+#else
 			uchar unused_bits:4;
+#endif
 		};
 	};
 
 	// The X,Y,Z data from the sensor
 	XYZVector data;
 
+#if ENABLE_REPORT_TIMESTAMPS
+	// clock_timestamp() of when the data above has been read
+	unsigned int timestamp;
+#endif
+
 	SensorEepromData e;
 
+#if !ENABLE_RAM_OVERLAY
 	// Zero calibration temporary values
+	// With ENABLE_RAM_OVERLAY, they live at mode_overlay (overlay.h).
 	XYZVector zero_min;
 	XYZVector zero_max;
+#endif
 
 	// Used to determine the next step in non-blocking functions.
 	// Must be set to zero to ensure each function starts from the beginning.
 	uchar func_step;
 
+#if ENABLE_ASYNC_STARTUP || ENABLE_BUS_RECOVERY
+	// State of sensor_startup()
+	uchar startup_step;
+	uchar probe_attempts;
+	unsigned int probe_time;
+#endif
+
+#if ENABLE_BUS_RECOVERY
+	// Consecutive failed readings, see busrecovery.c
+	uchar errors_in_a_row;
+#endif
+
 } SensorData;
 
 
@@ -92,6 +120,14 @@ extern SensorEepromData EEMEM eeprom_sensor;
 // Functions
 uchar sensor_read_data_registers();
 
+#if ENABLE_POLL_SYNC
+uchar sensor_start_single_measurement();
+#endif
+
+#if ENABLE_IDLE_SLEEP
+void sensor_set_idle(uchar idle);
+#endif
+
 void sensor_start_continuous_reading();
 void sensor_stop_continuous_reading();
 
@@ -99,6 +135,14 @@ uchar sensor_read_identification_string(uchar *s);
 
 void sensor_init_configuration();
 
+#if ENABLE_ASYNC_STARTUP || ENABLE_BUS_RECOVERY
+uchar sensor_startup();
+#endif
+
+#if ENABLE_BUS_RECOVERY
+void sensor_restart();
+#endif
+
 
 #endif  // __sensor_h_included____
 
@@ -0,0 +1,72 @@
+/* Name: stackmon.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Stack high-water mark.
+ *
+ * Right after reset, all RAM between the end of the global variables (_end)
+ * and the top of the stack (__stack, which is RAMEND) is filled with
+ * STACK_CANARY. The stack grows down from the top, and overwrites the
+ * canary. There is no malloc() in this firmware, so the canary bytes that
+ * are still intact at the bottom of that area have never been used by the
+ * stack since power-on.
+ *
+ * stack_unused_bytes() counts them, and is called whenever the diagnostics
+ * report is read. Zero means the stack has (probably) reached the global
+ * variables, and anything could have happened.
+ *
+ * Note that -mtiny-stack (see the Makefile) only changes the low byte of
+ * the stack pointer when allocating stack frames, so a frame that crosses
+ * a 256-byte boundary is also a problem, even with unused bytes left.
+ */
+
+
+#include "stackmon.h"
+
+
+#if ENABLE_STACK_MONITOR
+
+// Defined by the linker script and by avr-libc
+extern uchar _end;
+extern uchar __stack;
+
+
+// Runs at .init1, before the stack pointer and r1 (the "zero register")
+// are set up at .init2, so it must be written in assembly. Being "naked",
+// it has no "ret" and falls through to the next .init section.
+void stack_paint() __attribute__((naked, used, section(".init1")));
+void stack_paint() {  // {{{
+	__asm__ volatile (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		"	breq 1b\n"
+		:
+		: "M" (STACK_CANARY)
+	);
+}  // }}}
+
+
+unsigned int stack_unused_bytes() {  // {{{
+	// Takes about 5 cycles per unused byte.
+	const uchar *p = &_end;
+
+	while (p <= &__stack && *p == STACK_CANARY) {
+		p++;
+	}
+	return p - &_end;
+}  // }}}
+
+#endif  // ENABLE_STACK_MONITOR
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,28 @@
+/* Name: stackmon.h
+ *
+ * See the .c file for more information
+ */
+
+#ifndef __stackmon_h_included__
+#define __stackmon_h_included__
+
+#include "common.h"
+
+
+#if ENABLE_STACK_MONITOR
+
+#if !ENABLE_DIAGNOSTICS
+#error "ENABLE_STACK_MONITOR needs ENABLE_DIAGNOSTICS"
+#endif
+
+// Value written into the free RAM at boot
+#define STACK_CANARY 0xC5
+
+unsigned int stack_unused_bytes();
+
+#endif
+
+
+#endif  // __stackmon_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
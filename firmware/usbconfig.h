@@ -123,6 +123,10 @@
 /* This macro (if defined) is executed when a USB SET_ADDRESS request was
  * received.
  */
+// Used by ENABLE_POLL_SYNC and by the suspend detection of
+// ENABLE_IDLE_SLEEP, if available. But this board has the interrupt on D+,
+// so the USB lines must be swapped (and USB_CFG_DMINUS_BIT and
+// USB_CFG_DPLUS_BIT updated) before enabling this.
 #define USB_COUNT_SOF                   0
 /* define this macro to 1 if you need the global variable "usbSofCount" which
  * counts SOF packets. This feature requires that the hardware interrupt is
@@ -254,7 +258,10 @@
  * HID class is 3, no subclass and protocol required (but may be useful!)
  * CDC class is 2, use subclass 2 and protocol 1 for ACM
  */
-#define USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH    82
+// The report descriptor is declared at hidreport.h, and its length is
+// counted from the declaration.
+#include "hidreport.h"
+#define USB_CFG_HID_REPORT_DESCRIPTOR_LENGTH    HID_REPORT_DESCRIPTOR_LENGTH
 /* Define this to the length of the HID report descriptor, if you implement
  * an HID device. Otherwise don't define it or define it to 0.
  * If you use this define, you must add a PROGMEM character array named
@@ -0,0 +1,15 @@
+/* Name: interrupt.h
+ *
+ * Minimal stand-in for <avr/interrupt.h>, see io.h.
+ */
+
+#ifndef __avr_stubs_interrupt_h_included__
+#define __avr_stubs_interrupt_h_included__
+
+#define sei() do{ }while(0)
+#define cli() do{ }while(0)
+
+
+#endif  // __avr_stubs_interrupt_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,24 @@
+/* Name: io.h
+ *
+ * Minimal stand-in for <avr/io.h>, so that a few firmware files can be
+ * compiled and tested on the computer. Only what those files use is here.
+ * The "registers" are plain variables, defined by the test program.
+ */
+
+#ifndef __avr_stubs_io_h_included__
+#define __avr_stubs_io_h_included__
+
+extern unsigned char stub_PINC;
+extern unsigned char stub_TIFR;
+extern unsigned char stub_TCNT0;
+
+#define PINC   stub_PINC
+#define TIFR   stub_TIFR
+#define TCNT0  stub_TCNT0
+
+#define TOV0   0
+
+
+#endif  // __avr_stubs_io_h_included____
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,165 @@
+/* Name: debounce_test.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Replays bounce patterns against the button debouncer of the firmware
+ * (firmware/buttons.c, compiled as-is for the computer) and against the
+ * shift-register debouncer it replaced, and checks that both give the same
+ * button.state and button.changed after every sample.
+ *
+ * The old debouncer shifted each sample into an 8-bit register per button,
+ * and the button changed state when the register reached 0x00 or 0xFF. The
+ * firmware now uses a vertical counter, which must behave the same way.
+ *
+ * Build and run with "make test". Returns non-zero on the first mismatch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Firmware configuration being tested
+#define ENABLE_PIN_CHANGE_BUTTONS 0
+#define ENABLE_CLICK_REWIND 0
+#define ENABLE_DIAGNOSTICS 0
+
+#include "../firmware/buttons.c"
+
+
+unsigned char stub_PINC;
+unsigned char stub_TIFR;
+unsigned char stub_TCNT0;
+
+
+////////////////////////////////////////////////////////////
+// Reference debouncer                                   {{{
+
+// The shift-register debouncer used by the firmware before the vertical
+// counter, inspired by tiltstick-20080207 firmware.
+typedef struct ReferenceState {
+	uchar state;
+	uchar changed;
+	uchar debouncing[4];
+} ReferenceState;
+
+static void reference_update(ReferenceState *ref, uchar raw_state, uchar timer_overflow) {  // {{{
+	uchar filtered_state = ref->state;
+	uchar i;
+
+	if (timer_overflow) {
+		for (i = 0; i < 4; i++) {
+			ref->debouncing[i] =
+				(ref->debouncing[i] << 1)
+				| ((raw_state & (1 << i)) ? 1 : 0);
+
+			if (ref->debouncing[i] == 0) {
+				filtered_state &= ~(1 << i);
+			} else if (ref->debouncing[i] == 0xFF) {
+				filtered_state |= (1 << i);
+			}
+		}
+	}
+
+	ref->changed = ref->state ^ filtered_state;
+	ref->state = filtered_state;
+}  // }}}
+
+// }}}
+
+////////////////////////////////////////////////////////////
+// Replaying                                             {{{
+
+static ReferenceState reference;
+static unsigned long samples;
+
+// Small deterministic generator, so that every run replays the same
+// patterns on every computer.
+static unsigned long random_state = 1;
+static unsigned int next_random() {  // {{{
+	random_state = random_state * 1103515245 + 12345;
+	return (random_state >> 16) & 0x7FFF;
+}  // }}}
+
+static void replay(uchar raw_state, uchar timer_overflow) {  // {{{
+	// Buttons are ON when connected to GND, and read as zero
+	stub_PINC = ~raw_state;
+
+	update_button_state(timer_overflow);
+	reference_update(&reference, raw_state & ALL_BUTTONS, timer_overflow);
+	samples++;
+
+	if (button.state != reference.state || button.changed != reference.changed) {
+		printf(
+			"Mismatch at sample %lu (raw 0x%02X): state 0x%02X changed 0x%02X, "
+			"expected state 0x%02X changed 0x%02X\n",
+			samples, raw_state,
+			button.state, button.changed,
+			reference.state, reference.changed
+		);
+		exit(1);
+	}
+}  // }}}
+
+static void replay_tick(uchar raw_state) {  // {{{
+	// Several iterations of the main loop happen between two ticks
+	replay(raw_state, 1);
+	replay(raw_state, 0);
+}  // }}}
+
+static void replay_bounce(uchar from, uchar to, uchar bounces, uchar length) {  // {{{
+	// The buttons go from one state to the other, bouncing a few
+	// times, each bounce lasting "length" ticks, and then stay there.
+	uchar i;
+	uchar j;
+
+	for (i = 0; i < bounces; i++) {
+		for (j = 0; j < length; j++) {
+			replay_tick((i & 1) ? from : to);
+		}
+	}
+	for (i = 0; i < 12; i++) {
+		replay_tick(to);
+	}
+}  // }}}
+
+// }}}
+
+
+int main() {  // {{{
+	uchar mask;
+	uchar bounces;
+	uchar length;
+	unsigned long i;
+
+	// Clean and bouncy presses and releases of each button, and of all of
+	// them at once, with bounces shorter and longer than the filter
+	for (mask = 1; mask <= ALL_BUTTONS; mask++) {
+		for (bounces = 1; bounces <= 9; bounces += 2) {
+			for (length = 1; length <= 10; length++) {
+				replay_bounce(0, mask, bounces, length);
+				replay_bounce(mask, 0, bounces, length);
+			}
+		}
+	}
+
+	// Random noise, with long and short runs of the same value
+	for (i = 0; i < 1000000; i++) {
+		uchar raw = next_random() & ALL_BUTTONS;
+		uchar run = next_random() % 12;
+		while (run--) {
+			replay_tick(raw);
+		}
+		if (next_random() & 1) {
+			// Noise on a single button
+			replay_tick(raw ^ (1 << (next_random() & 3)));
+		}
+	}
+
+	printf("OK, %lu samples.\n", samples);
+	return 0;
+}  // }}}
+
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Reads the diagnostics feature report from a firmware built with
+# ENABLE_DIAGNOSTICS = 1, and prints the startup timings, the error counters,
+# the button latency and the unused stack:
+#   ./diagnostics_dump.py /dev/hidraw3
+#
+# All times are measured by the device since power-on (actually, since
+# Timer0 was started at hardware_init()), in Timer0 ticks of 1.365ms.
+#
+# For a cold start time-to-first-report figure, hold the switch down while
+# plugging the device, so that the first mouse report is sent as soon as
+# possible.
+
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import array
+import fcntl
+import struct
+
+
+# Must match firmware/diagnostics.h
+DIAGNOSTICS_REPORT_ID = 5
+REPORT_FORMAT = '<BBHHHHB' + 'H' * 8
+REPORT_SIZE = struct.calcsize(REPORT_FORMAT)
+
+DIAG_USB_RESET_DONE = 1 << 0
+DIAG_SENSOR_READY = 1 << 1
+DIAG_SENSOR_MISSING = 1 << 2
+DIAG_USB_CONFIGURED = 1 << 3
+DIAG_FIRST_REPORT = 1 << 4
+
+TICK_MS = 64 * 256 / 12000.0
+TIMESTAMP_MS = 64 / 12000.0
+
+
+def HIDIOCGFEATURE(length):
+    # From linux/hidraw.h:
+    # _IOC(_IOC_WRITE|_IOC_READ, 'H', 0x07, len)
+    IOC_WRITE = 1
+    IOC_READ = 2
+    return ((IOC_WRITE | IOC_READ) << 30) | (length << 16) | (ord('H') << 8) | 0x07
+
+
+def read_report(path):
+    with open(path, 'rb+', 0) as f:
+        buf = array.array('B', [0] * REPORT_SIZE)
+        buf[0] = DIAGNOSTICS_REPORT_ID
+        fcntl.ioctl(f, HIDIOCGFEATURE(REPORT_SIZE), buf, True)
+        data = buf.tostring() if hasattr(buf, 'tostring') else buf.tobytes()
+        return struct.unpack(REPORT_FORMAT, data)
+
+
+def print_event(name, happened, ticks):
+    if happened:
+        print('{0:<24s} {1:6d} ticks {2:9.2f} ms'.format(name, ticks, ticks * TICK_MS))
+    else:
+        print('{0:<24s} (not yet)'.format(name))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Prints the startup timings of the firmware'
+    )
+    parser.add_argument(
+        'hidraw',
+        action='store',
+        metavar='DEVICE',
+        help='hidraw device of the mouse (e.g. /dev/hidraw3)'
+    )
+    options = parser.parse_args()
+
+    (
+        report_id, events,
+        usb_reset_done, sensor_ready, usb_configured, first_report,
+        sensor_probe_attempts,
+        twi_errors, twi_timeouts, bus_recoveries, sensor_reinits,
+        lost_samples,
+        button_latency_last, button_latency_max,
+        stack_unused
+    ) = read_report(options.hidraw)
+
+    print_event('USB reset done', events & DIAG_USB_RESET_DONE, usb_reset_done)
+    if events & DIAG_SENSOR_MISSING:
+        print_event('Sensor given up', True, sensor_ready)
+    else:
+        print_event('Sensor ready', events & DIAG_SENSOR_READY, sensor_ready)
+    print_event('USB configured', events & DIAG_USB_CONFIGURED, usb_configured)
+    print_event('First mouse report', events & DIAG_FIRST_REPORT, first_report)
+    print('Sensor probe attempts: {0}'.format(sensor_probe_attempts))
+    print()
+
+    # Only counted if the firmware was built with ENABLE_BUS_RECOVERY = 1,
+    # except for TWI errors and lost samples.
+    print('TWI errors:     {0}'.format(twi_errors))
+    print('TWI timeouts:   {0}'.format(twi_timeouts))
+    print('Bus recoveries: {0}'.format(bus_recoveries))
+    print('Sensor reinits: {0}'.format(sensor_reinits))
+    print('Lost samples:   {0}'.format(lost_samples))
+    print()
+
+    # Only measured if the firmware was built with
+    # ENABLE_PIN_CHANGE_BUTTONS = 1.
+    print('Press-to-report latency: last {0:.2f} ms, max {1:.2f} ms'.format(
+        button_latency_last * TIMESTAMP_MS,
+        button_latency_max * TIMESTAMP_MS
+    ))
+
+    # Only measured if the firmware was built with ENABLE_STACK_MONITOR = 1.
+    if stack_unused == 0xFFFF:
+        print('Unused stack: (not measured)')
+    elif stack_unused == 0:
+        print('Unused stack: 0 bytes - THE STACK HAS REACHED THE GLOBAL VARIABLES!')
+    else:
+        print('Unused stack: {0} bytes'.format(stack_unused))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,224 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Reads the main-loop profiling counters from a firmware built with
+# ENABLE_PROFILING = 1, and prints how many CPU cycles each stage takes.
+#
+# The counters are kept in a HID feature report (ID 4), which is read
+# through the hidraw device:
+#   ./profile_dump.py /dev/hidraw3
+#
+# The firmware never resets the counters. In order to look at a specific
+# period of time, use --interval, which reads the report twice and prints
+# only the difference (min and max are still the all-time values).
+#
+# All numbers include the time spent inside interrupts (mostly V-USB), and
+# any stage taking more than 65536 cycles (5.46ms) is measured wrong,
+# because Timer1 wraps around.
+#
+# With ENABLE_IDLE_SLEEP = 1, the "sleep" stage is the time the CPU has
+# spent sleeping, which is the time saved from the busy loop. The script
+# also prints how many iterations of the main loop ended in sleep and, with
+# --interval, which fraction of the time the CPU was asleep.
+#
+# With ENABLE_SCHEDULER = 1, the report also carries the scheduler
+# statistics: the longest run of each task, how many times it started late
+# or overran its budget, and the longest interval between two usbPoll()
+# calls, compared with the 50ms that V-USB can tolerate.
+
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import array
+import fcntl
+import struct
+import time
+
+
+# Must match firmware/profiling.h
+PROFILE_REPORT_ID = 4
+STAGE_NAMES = [
+    'usbPoll',
+    'buttons',
+    'sensor',
+    'projection',
+    'menu',
+    'report',
+    'sleep',
+]
+LOOP_BINS = 8
+LOOP_FIRST_LIMIT = 512
+# Must match scheduler_tasks[] at firmware/main.c (see the STATIC_ASSERT
+# after it)
+TASK_NAMES = [
+    'buttons',
+    'sensor',
+]
+
+REPORT_FORMAT = (
+    '<B' + 'HHLL' * len(STAGE_NAMES) + 'L' * LOOP_BINS
+    + 'HBB' * len(TASK_NAMES) + 'H'
+)
+REPORT_SIZE = struct.calcsize(REPORT_FORMAT)
+
+CYCLES_PER_US = 12.0
+# clock_timestamp() units, see firmware/clock.h
+TIMESTAMP_MS = 64 / 12000.0
+USBPOLL_DEADLINE_MS = 50
+
+
+def HIDIOCGFEATURE(length):
+    # From linux/hidraw.h:
+    # _IOC(_IOC_WRITE|_IOC_READ, 'H', 0x07, len)
+    IOC_WRITE = 1
+    IOC_READ = 2
+    return ((IOC_WRITE | IOC_READ) << 30) | (length << 16) | (ord('H') << 8) | 0x07
+
+
+class Profile(object):
+    def __init__(self, data):
+        values = struct.unpack(REPORT_FORMAT, data)
+        if values[0] != PROFILE_REPORT_ID:
+            raise ValueError('Unexpected report ID {0}'.format(values[0]))
+        values = values[1:]
+
+        # List of (min, max, total, count)
+        self.stages = [
+            values[i * 4:(i + 1) * 4] for i in range(len(STAGE_NAMES))
+        ]
+        values = values[len(STAGE_NAMES) * 4:]
+        self.loop_histogram = list(values[:LOOP_BINS])
+        values = values[LOOP_BINS:]
+
+        # List of (max_runtime, deadline_misses, budget_overruns)
+        self.tasks = [
+            values[i * 3:(i + 1) * 3] for i in range(len(TASK_NAMES))
+        ]
+        self.max_usbpoll_interval = values[-1]
+
+    def __sub__(self, other):
+        # Difference between two reads. Counters are 32-bit and wrap around.
+        result = Profile.__new__(Profile)
+        result.stages = [
+            (mi, ma, (tot - otot) % 2**32, (cnt - ocnt) % 2**32)
+            for (mi, ma, tot, cnt), (omi, oma, otot, ocnt)
+            in zip(self.stages, other.stages)
+        ]
+        result.loop_histogram = [
+            (a - b) % 2**32
+            for a, b in zip(self.loop_histogram, other.loop_histogram)
+        ]
+        # The scheduler counters saturate instead of wrapping around
+        result.tasks = [
+            (ma, mi - omi, bo - obo)
+            for (ma, mi, bo), (oma, omi, obo)
+            in zip(self.tasks, other.tasks)
+        ]
+        result.max_usbpoll_interval = self.max_usbpoll_interval
+        return result
+
+
+def read_profile(path):
+    with open(path, 'rb+', 0) as f:
+        buf = array.array('B', [0] * REPORT_SIZE)
+        buf[0] = PROFILE_REPORT_ID
+        fcntl.ioctl(f, HIDIOCGFEATURE(REPORT_SIZE), buf, True)
+        return Profile(buf.tostring() if hasattr(buf, 'tostring') else buf.tobytes())
+
+
+def print_sleep_ratio(profile, interval):
+    sleep_total, sleep_count = profile.stages[STAGE_NAMES.index('sleep')][2:4]
+    iterations = sum(profile.loop_histogram)
+    if sleep_count == 0 or iterations == 0:
+        return
+    print('Iterations ending in sleep: {0} of {1} ({2:.1f}%)'.format(
+        sleep_count, iterations, 100.0 * sleep_count / iterations))
+    if interval > 0:
+        # Timer1 wraps around every 65536 cycles, so longer sleeps are
+        # undercounted
+        print('Time asleep: {0:.1f}%'.format(
+            100.0 * sleep_total / (interval * CYCLES_PER_US * 1e6)))
+    print()
+
+
+def print_profile(profile):
+    print('{0:<12s} {1:>10s} {2:>8s} {3:>8s} {4:>10s} {5:>10s}'.format(
+        'stage', 'count', 'min', 'max', 'average', 'avg (us)'))
+    for name, (mi, ma, total, count) in zip(STAGE_NAMES, profile.stages):
+        if count == 0:
+            print('{0:<12s} {1:>10d}'.format(name, count))
+            continue
+        average = total / count
+        print('{0:<12s} {1:>10d} {2:>8d} {3:>8d} {4:>10.1f} {5:>10.1f}'.format(
+            name, count, mi, ma, average, average / CYCLES_PER_US))
+    print()
+
+    print('Main loop iteration duration:')
+    total = sum(profile.loop_histogram) or 1
+    biggest = max(profile.loop_histogram) or 1
+    low = 0
+    limit = LOOP_FIRST_LIMIT
+    for i, count in enumerate(profile.loop_histogram):
+        if i == LOOP_BINS - 1:
+            label = '>= {0} cycles'.format(low)
+        else:
+            label = '{0} .. {1} cycles'.format(low, limit - 1)
+        bar = '#' * int(round(40 * count / biggest))
+        print('  {0:<22s} {1:>10d} {2:6.2f}% {3}'.format(
+            label, count, 100.0 * count / total, bar))
+        low = limit
+        limit *= 2
+    print()
+
+    if profile.max_usbpoll_interval == 0:
+        print('Scheduler: (not measured)')
+        return
+    print('{0:<12s} {1:>12s} {2:>10s} {3:>10s}'.format(
+        'task', 'max run (ms)', 'late', 'overruns'))
+    for name, (max_runtime, misses, overruns) in zip(TASK_NAMES, profile.tasks):
+        print('{0:<12s} {1:>12.2f} {2:>10d} {3:>10d}'.format(
+            name, max_runtime * TIMESTAMP_MS, misses, overruns))
+    interval = profile.max_usbpoll_interval * TIMESTAMP_MS
+    print('Longest usbPoll() interval: {0:.2f} ms, slack {1:.2f} ms{2}'.format(
+        interval, USBPOLL_DEADLINE_MS - interval,
+        ' - DEADLINE MISSED!' if interval > USBPOLL_DEADLINE_MS else ''))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description='Prints the main-loop profiling counters of the firmware',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter
+    )
+    parser.add_argument(
+        'hidraw',
+        action='store',
+        metavar='DEVICE',
+        help='hidraw device of the mouse (e.g. /dev/hidraw3)'
+    )
+    parser.add_argument(
+        '-i', '--interval',
+        action='store',
+        type=float,
+        default=0,
+        metavar='SECONDS',
+        help='Read twice, this many seconds apart, and print the difference (0 prints the totals since power-on)'
+    )
+    return parser.parse_args()
+
+
+def main():
+    options = parse_args()
+
+    profile = read_profile(options.hidraw)
+    if options.interval > 0:
+        time.sleep(options.interval)
+        profile = read_profile(options.hidraw) - profile
+
+    print_profile(profile)
+    print_sleep_ratio(profile, options.interval)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,264 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Analyzes the timing of the mouse reports sent by a firmware built with
+# ENABLE_REPORT_TIMESTAMPS = 1.
+#
+# Each mouse report carries a 5-bit sequence number and the 16-bit device
+# timestamp of the sensor sample used for that position. This script
+# correlates them with the time each report arrived at the computer, and
+# prints histograms of:
+#
+# * the latency from the sensor sample until the report arrival;
+# * the interval between arrivals;
+# * the number of reports lost between two received reports.
+#
+# The reports can be read from:
+#
+# * A usbmon text log (see Documentation/usb/usbmon.txt in Linux source):
+#     cat /sys/kernel/debug/usb/usbmon/3u > log.txt
+#     ./report_latency.py --usbmon log.txt
+# * A hidraw device, in real time (press Ctrl+C to stop and print):
+#     ./report_latency.py --hidraw /dev/hidraw3
+#
+# The device and the computer do not share a clock, so the absolute latency
+# cannot be known. Instead, the smallest (sample -> arrival) difference is
+# taken as the zero, and the latency histogram shows how much later than
+# that each report arrived. A linear fit of the lower envelope removes the
+# drift between both crystals.
+
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import re
+import struct
+import sys
+import time
+
+
+# Must match the firmware (MouseReport in firmware/mouseemu.h)
+MOUSE_REPORT_ID = 2
+MOUSE_REPORT_SIZE = 8
+SEQUENCE_MODULO = 32
+
+# One device timestamp unit is one TCNT0 step: 64 / 12MHz = 5.333us
+TIMESTAMP_UNIT_US = 64 / 12.0
+TIMESTAMP_MODULO = 65536
+TIMESTAMP_WRAP_US = TIMESTAMP_MODULO * TIMESTAMP_UNIT_US
+
+
+class Report(object):
+    def __init__(self, arrival_us, data):
+        # arrival_us is the host time, in microseconds
+        self.arrival_us = arrival_us
+        (
+            self.report_id, self.x, self.y, flags, self.timestamp
+        ) = struct.unpack('<BHHBH', data)
+        self.buttons = flags & 0x07
+        self.sequence = flags >> 3
+        # Filled by unwrap_timestamps()
+        self.device_us = None
+
+    def __repr__(self):
+        return 'Report({arrival_us}, seq={sequence}, ts={timestamp}, x={x}, y={y}, b={buttons})'.format(**self.__dict__)
+
+
+def parse_usbmon(f):
+    # Example line (timestamp is in microseconds):
+    # ffff88000c9a0600 1465973871 C Ii:5:093:1 0:8 6 = 02ff0fff 0f00
+    re_line = re.compile(r'^\S+\s+(\d+)\s+C\s+Ii:\S+\s+0(?::\d+)?\s+(\d+)\s+=\s+([0-9a-fA-F ]+)$')
+
+    for line in f:
+        match = re_line.match(line.strip())
+        if not match:
+            continue
+        arrival_us = int(match.group(1))
+        length = int(match.group(2))
+        data = bytearray.fromhex(match.group(3).replace(' ', ''))[:length]
+        if len(data) == MOUSE_REPORT_SIZE and data[0] == MOUSE_REPORT_ID:
+            yield Report(arrival_us, bytes(data))
+
+
+def read_hidraw(path):
+    with open(path, 'rb', 0) as f:
+        try:
+            while True:
+                data = f.read(64)
+                arrival_us = int(time.time() * 1e6)
+                if len(data) == MOUSE_REPORT_SIZE and bytearray(data)[0] == MOUSE_REPORT_ID:
+                    yield Report(arrival_us, data)
+        except KeyboardInterrupt:
+            pass
+
+
+def unwrap_timestamps(reports):
+    # The device timestamp wraps around every 349.5ms. The host arrival time
+    # is used to guess how many times it has wrapped between two reports.
+    prev = None
+    for r in reports:
+        if prev is None:
+            r.device_us = r.timestamp * TIMESTAMP_UNIT_US
+        else:
+            expected = prev.device_us + (r.arrival_us - prev.arrival_us)
+            base = r.timestamp * TIMESTAMP_UNIT_US
+            wraps = round((expected - base) / TIMESTAMP_WRAP_US)
+            r.device_us = base + wraps * TIMESTAMP_WRAP_US
+        prev = r
+
+
+def fit_lower_envelope(points):
+    # Fits a line below all points (x, y), by taking the minimum y of each
+    # of a few slices and doing a least-squares fit over those minima.
+    # Returns (slope, intercept).
+    if len(points) < 2:
+        return 0.0, min(y for x, y in points)
+
+    points = sorted(points)
+    slices = min(16, len(points))
+    minima = []
+    for i in range(slices):
+        chunk = points[i * len(points) // slices:(i + 1) * len(points) // slices]
+        if chunk:
+            minima.append(min(chunk, key=lambda p: p[1]))
+
+    n = len(minima)
+    mean_x = sum(x for x, y in minima) / n
+    mean_y = sum(y for x, y in minima) / n
+    sxx = sum((x - mean_x) ** 2 for x, y in minima)
+    if sxx == 0:
+        slope = 0.0
+    else:
+        slope = sum((x - mean_x) * (y - mean_y) for x, y in minima) / sxx
+    # Shifting the line down, so that no point is below it
+    intercept = min(y - slope * x for x, y in points)
+    return slope, intercept
+
+
+def print_histogram(title, values, bin_size, unit):
+    print(title)
+    if not values:
+        print('  (no data)')
+        print()
+        return
+
+    bins = {}
+    for v in values:
+        b = int(v // bin_size)
+        bins[b] = bins.get(b, 0) + 1
+
+    biggest = max(bins.values())
+    for b in range(min(bins), max(bins) + 1):
+        count = bins.get(b, 0)
+        bar = '#' * int(round(50 * count / biggest))
+        print('  {0:8.2f} .. {1:8.2f} {2} {3:6d} {4}'.format(
+            b * bin_size, (b + 1) * bin_size, unit, count, bar))
+
+    values = sorted(values)
+    print('  count={0} min={1:.2f} median={2:.2f} p95={3:.2f} max={4:.2f} {5}'.format(
+        len(values),
+        values[0],
+        values[len(values) // 2],
+        values[min(len(values) - 1, int(len(values) * 0.95))],
+        values[-1],
+        unit))
+    print()
+
+
+def analyze(reports, options):
+    reports = list(reports)
+    if not reports:
+        print('No mouse reports found. Was the firmware built with ENABLE_REPORT_TIMESTAMPS = 1?')
+        return
+
+    unwrap_timestamps(reports)
+
+    # Lost reports, from the sequence number
+    lost = []
+    for prev, r in zip(reports, reports[1:]):
+        lost.append((r.sequence - prev.sequence - 1) % SEQUENCE_MODULO)
+
+    # Interval between arrivals
+    intervals = [
+        (r.arrival_us - prev.arrival_us) / 1000.0
+        for prev, r in zip(reports, reports[1:])
+    ]
+
+    # Latency, only for reports carrying a new sensor sample (a report
+    # caused only by a button change repeats the previous timestamp).
+    fresh = [reports[0]] + [
+        r for prev, r in zip(reports, reports[1:])
+        if r.timestamp != prev.timestamp
+    ]
+    points = [(r.device_us, r.arrival_us - r.device_us) for r in fresh]
+    if options.no_drift:
+        slope, intercept = 0.0, min(y for x, y in points)
+    else:
+        slope, intercept = fit_lower_envelope(points)
+    latencies = [(y - (slope * x + intercept)) / 1000.0 for x, y in points]
+
+    total_lost = sum(lost)
+    print('Reports received: {0}'.format(len(reports)))
+    print('Reports lost: {0} ({1:.2f}%)'.format(
+        total_lost, 100.0 * total_lost / (total_lost + len(reports))))
+    print('Reports with a new sensor sample: {0}'.format(len(fresh)))
+    print('Clock drift (host clock relative to device clock): {0:+.1f} ppm'.format(slope * 1e6))
+    print()
+
+    print_histogram('Latency above the minimum (sample -> arrival):', latencies, options.bin, 'ms')
+    print_histogram('Interval between arrivals:', intervals, options.bin, 'ms')
+    print_histogram('Lost reports between two received ones:', lost, 1, '  ')
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description='Prints latency and drop histograms from the timestamped mouse reports',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter
+    )
+
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument(
+        '-u', '--usbmon',
+        action='store',
+        type=argparse.FileType('r'),
+        metavar='FILE',
+        help='Read a usbmon text log ("-" for stdin)'
+    )
+    group.add_argument(
+        '-d', '--hidraw',
+        action='store',
+        metavar='DEVICE',
+        help='Read reports in real time from a hidraw device, until Ctrl+C'
+    )
+
+    parser.add_argument(
+        '-b', '--bin',
+        action='store',
+        type=float,
+        default=1.0,
+        metavar='MS',
+        help='Histogram bin size'
+    )
+    parser.add_argument(
+        '--no-drift',
+        action='store_true',
+        help='Do not compensate the clock drift between the device and the host'
+    )
+
+    return parser.parse_args()
+
+
+def main():
+    options = parse_args()
+
+    if options.usbmon:
+        reports = parse_usbmon(options.usbmon)
+    else:
+        reports = read_hidraw(options.hidraw)
+
+    analyze(reports, options)
+
+
+if __name__ == '__main__':
+    main()
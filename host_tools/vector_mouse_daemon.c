@@ -0,0 +1,903 @@
+/* Name: vector_mouse_daemon.c
+ * Project: atmega8-magnetometer-usb-mouse
+ * Author: Denilson Figueiredo de Sa
+ * Creation Date: 2026-10-19
+ * Tabsize: 4
+ * License: GNU GPL v2 or GNU GPL v3
+ *
+ * Host-side counterpart of the ENABLE_HOST_PROJECTION firmware mode.
+ *
+ * The firmware streams the zero-compensated X,Y,Z vector from the sensor
+ * (vendor-defined report ID 3, see VectorReport in firmware/mouseemu.h).
+ * This program reads those reports from hidraw, converts the 3D vectors
+ * into 2D screen coordinates, applies the smoothing filter (and optionally
+ * some prediction), and moves the pointer by writing absolute events to a
+ * uinput device.
+ *
+ * Since the computer has plenty of CPU, all math is done in double
+ * precision, and any of the algorithms from projection/convert_coordinates.py
+ * can be used. The samples are processed in batches, stored as separate
+ * arrays for each component, so that the compiler can vectorize the main
+ * loops (try "make CFLAGS+=-O3 CFLAGS+=-march=native").
+ *
+ * For testing without the hardware, the --replay option reads a recorded
+ * log (the same format accepted by convert_coordinates.py and
+ * linear_eq_conversion.c), packs each vector into an actual HID report and
+ * feeds it to the very same report-handling code used for hidraw. In other
+ * words, it simulates the device. Combine it with --print to compare the
+ * results against the Python implementation:
+ *
+ *   cat ../projection/2011-10-24_calibration.txt ../projection/2011-10-24_values.txt \
+ *     | ./vector_mouse_daemon --replay - --print --smoothing 0 --algorithm 7
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+
+////////////////////////////////////////////////////////////
+// Definitions                                           {{{
+
+// Must match the firmware (firmware/mouseemu.h)
+#define VECTOR_REPORT_ID      3
+#define VECTOR_REPORT_SIZE    8
+#define VECTOR_FLAG_BUTTONS   0x07
+#define VECTOR_FLAG_OVERFLOW  0x08
+
+// Maximum number of samples processed at once
+#define BATCH_SIZE 64
+
+// Range of the absolute axes at uinput
+#define ABS_RANGE 65535
+
+// Indexes for the calibration corners
+enum {
+	TOPLEFT = 0,
+	TOPRIGHT,
+	BOTTOMLEFT,
+	BOTTOMRIGHT,
+	TOTAL_CORNERS
+};
+
+static const char *corner_names[TOTAL_CORNERS] = {
+	"topleft",
+	"topright",
+	"bottomleft",
+	"bottomright"
+};
+
+typedef struct Vector {
+	double x, y, z;
+} Vector;
+
+// A batch of samples, stored as structure-of-arrays.
+typedef struct Batch {
+	int count;
+	double x[BATCH_SIZE];
+	double y[BATCH_SIZE];
+	double z[BATCH_SIZE];
+	// Timestamp of each sample, in seconds
+	double t[BATCH_SIZE];
+	unsigned char flags[BATCH_SIZE];
+
+	// Results of the projection, between 0.0 and 1.0 if inside the screen
+	double u[BATCH_SIZE];
+	double v[BATCH_SIZE];
+	// Non-zero if (u,v) is valid
+	unsigned char valid[BATCH_SIZE];
+} Batch;
+
+typedef struct SmoothingVars {
+	double first;
+	double second;
+} SmoothingVars;
+
+typedef struct Options {
+	const char *device;
+	const char *replay;
+	const char *calibration;
+	double replay_rate;
+	int algorithm;
+	double alpha;
+	double predict;
+	double freeze;
+	int use_uinput;
+	int print;
+	int verbose;
+} Options;
+
+typedef struct State {
+	Vector corners[TOTAL_CORNERS];
+	SmoothingVars smooth[2];
+	int smooth_initialized;
+
+	// Last state sent to the output
+	unsigned char buttons;
+	int abs_x, abs_y;
+
+	// Pointer updates are ignored until this time (after a click)
+	double frozen_until;
+
+	// Statistics
+	unsigned long reports;
+	unsigned long discarded;
+	unsigned long overflows;
+} State;
+
+static Options options;
+static State state;
+static Batch batch;
+
+static int uinput_fd = -1;
+static volatile sig_atomic_t should_quit = 0;
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Vector math                                           {{{
+
+static inline Vector vec(double x, double y, double z) {
+	Vector v = {x, y, z};
+	return v;
+}
+static inline Vector vsub(Vector a, Vector b) {
+	return vec(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+static inline Vector vscale(Vector a, double s) {
+	return vec(a.x * s, a.y * s, a.z * s);
+}
+static inline double vdot(Vector a, Vector b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+static inline Vector vcross(Vector a, Vector b) {
+	return vec(
+		a.y * b.z - a.z * b.y,
+		a.z * b.x - a.x * b.z,
+		a.x * b.y - a.y * b.x
+	);
+}
+static inline double vnorm(Vector a) {
+	return sqrt(vdot(a, a));
+}
+static inline Vector vunit(Vector a) {
+	return vscale(a, 1.0 / vnorm(a));
+}
+static inline double cos_between_vectors(Vector a, Vector b) {
+	return vdot(a, b) / vnorm(a) / vnorm(b);
+}
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Projection algorithms                                 {{{
+
+// Algorithm numbers are the same as convert_coordinates.py, plus:
+//  0 = The same linear system solved by the firmware (mouseemu.c)
+#define MIN_ALGORITHM 0
+#define MAX_ALGORITHM 13
+
+typedef enum EdgeMethod {
+	USING_ANGLE,
+	USING_COS,
+	USING_SIN,
+	USING_TAN,
+	USING_DIST,
+	USING_EXACT
+} EdgeMethod;
+
+static void project_linear_system(Batch *b, Vector A, Vector B, Vector D, double min, double max) {  // {{{
+	// Solves, for each sample P, the system:
+	//   u*(B-A) + v*(D-A) - t*P = -A
+	// using Cramer's rule. This loop has no branches and no function calls,
+	// which allows the compiler to vectorize it.
+	//
+	// Writing the matrix as M = [c1 c2 c3], where c3 = -P:
+	//   det(M) = c3 . (c1 x c2)
+	//   u = det([-A c2 c3]) / det(M) = c3 . (-A x c2) / det(M)
+	//   v = det([c1 -A c3]) / det(M) = c3 . (c1 x -A) / det(M)
+
+	Vector c1 = vsub(B, A);
+	Vector c2 = vsub(D, A);
+	Vector minusA = vscale(A, -1.0);
+	Vector n12 = vcross(c1, c2);
+	Vector na2 = vcross(minusA, c2);
+	Vector n1a = vcross(c1, minusA);
+	int i;
+
+	for (i = 0; i < b->count; i++) {
+		double px = -b->x[i];
+		double py = -b->y[i];
+		double pz = -b->z[i];
+		double det = px * n12.x + py * n12.y + pz * n12.z;
+		double u = (px * na2.x + py * na2.y + pz * na2.z) / det;
+		double v = (px * n1a.x + py * n1a.y + pz * n1a.z) / det;
+
+		b->u[i] = u;
+		b->v[i] = v;
+		// NaN and infinity (from a singular matrix) fail these comparisons.
+		b->valid[i] = (u >= min) & (u <= max) & (v >= min) & (v <= max);
+	}
+}  // }}}
+
+static int single_edge_interpolation(Vector A, Vector B, Vector C, EdgeMethod using, double *result) {  // {{{
+	// A and B are one of the corners.
+	// C is the currently pointed value.
+	//
+	// Port of State.single_edge_interpolation() from
+	// projection/convert_coordinates.py. Please read the comments there.
+	//
+	// Returns 0 in case of errors, or 1 and stores at *result a value that
+	// means how close to A is C, inside the segment AB.
+	//
+	// Unlike the Python version, this one never modifies the corner
+	// vectors.
+
+	Vector N, Clinha;
+	double NdotC;
+	double cos_AB, cos_AC, cos_BC;
+
+	// N is normal to the plane of A and B
+	N = vunit(vcross(A, B));
+
+	// Checking the side of C, in relation to N and plane AB
+	NdotC = vdot(N, C);
+	if (NdotC < 0) {
+		return 0;
+	}
+
+	// Clinha is the projection of C onto AB plane.
+	Clinha = vsub(C, vscale(N, NdotC));
+
+	cos_AB = cos_between_vectors(A, B);
+	cos_AC = cos_between_vectors(A, Clinha);
+	cos_BC = cos_between_vectors(B, Clinha);
+
+	if (!(
+		-1 <= cos_AB && cos_AB <= 1 &&
+		-1 <= cos_AC && cos_AC <= 1 &&
+		-1 <= cos_BC && cos_BC <= 1
+	)) {
+		return 0;
+	}
+
+	switch (using) {
+		case USING_ANGLE:
+			*result = acos(cos_AC) / acos(cos_AB);
+			return 1;
+
+		case USING_COS:
+			*result = (1 - cos_AC) / (1 - cos_AB);
+			return 1;
+
+		case USING_SIN:
+			*result = sqrt(1 - cos_AC * cos_AC) / sqrt(1 - cos_AB * cos_AB);
+			return 1;
+
+		case USING_TAN:
+			*result =
+				(sqrt(1 - cos_AC * cos_AC) / cos_AC)
+				/ (sqrt(1 - cos_AB * cos_AB) / cos_AB);
+			return 1;
+
+		case USING_DIST:
+			A = vunit(A);
+			B = vunit(B);
+			Clinha = vunit(Clinha);
+			*result = vnorm(vsub(A, Clinha)) / vnorm(vsub(A, B));
+			return 1;
+
+		case USING_EXACT: {
+			// Intersection between the edge A + alpha*(B-A) and the
+			// pointed direction beta*Clinha, solved in a 2D coordinate
+			// system on the AB plane.
+			Vector X = vunit(A);
+			Vector Y = vunit(vcross(A, N));
+			Vector BA = vsub(B, A);
+			double Cx = vdot(Clinha, X);
+			double Cy = vdot(Clinha, Y);
+			double Ax = vdot(A, X);
+			double Ay = vdot(A, Y);
+			double BAx = vdot(BA, X);
+			double BAy = vdot(BA, Y);
+			// [BAx -Cx] [alpha] = [-Ax]
+			// [BAy -Cy] [beta ]   [-Ay]
+			double det = BAx * (-Cy) - (-Cx) * BAy;
+			if (fabs(det) < 1e-12) {
+				return 0;
+			}
+			*result = ((-Ax) * (-Cy) - (-Cx) * (-Ay)) / det;
+			return 1;
+		}
+	}
+	return 0;
+}  // }}}
+
+static int interpolation_using_2_edges(const Vector *c, Vector P, EdgeMethod using, double *x, double *y) {  // {{{
+	// This is a very bad approximation
+	if (!single_edge_interpolation(c[TOPLEFT], c[TOPRIGHT], P, using, x)) return 0;
+	if (!single_edge_interpolation(c[BOTTOMLEFT], c[TOPLEFT], P, using, y)) return 0;
+	*y = 1 - *y;
+	return 1;
+}  // }}}
+
+static int interpolation_using_4_edges(const Vector *c, Vector P, EdgeMethod using, double *x, double *y) {  // {{{
+	// Port of State.interpolation_using_4_edges() from
+	// convert_coordinates.py. Read the comments there for the math.
+	double AB, BC, DC, AD;
+
+	if (!single_edge_interpolation(c[TOPLEFT]    , c[TOPRIGHT]   , P, using, &AB)) return 0;
+	if (!single_edge_interpolation(c[TOPRIGHT]   , c[BOTTOMRIGHT], P, using, &BC)) return 0;
+	if (!single_edge_interpolation(c[BOTTOMRIGHT], c[BOTTOMLEFT] , P, using, &DC)) return 0;
+	if (!single_edge_interpolation(c[BOTTOMLEFT] , c[TOPLEFT]    , P, using, &AD)) return 0;
+
+	DC = 1 - DC;
+	AD = 1 - AD;
+
+	*x = (AD * (DC - AB) + AB) / (1 - (BC - AD) * (DC - AB));
+	*y = *x * (BC - AD) + AD;
+	return 1;
+}  // }}}
+
+static void project_batch(Batch *b) {  // {{{
+	const Vector *c = state.corners;
+	int i;
+
+	if (options.algorithm == 0) {
+		// Same as the firmware: no normalization, and the same bounds.
+		project_linear_system(b, c[TOPLEFT], c[TOPRIGHT], c[BOTTOMLEFT], -0.25, 1.25);
+	} else if (options.algorithm == 13) {
+		// Same as convert_coordinates.py: normalized corners, and no
+		// bounds checking (other than being a finite number).
+		project_linear_system(b,
+			vunit(c[TOPLEFT]), vunit(c[TOPRIGHT]), vunit(c[BOTTOMLEFT]),
+			-INFINITY, INFINITY);
+	} else {
+		// The edge-based algorithms have too many branches to be
+		// vectorized, so they are computed one sample at a time.
+		int four_edges = options.algorithm >= 7;
+		EdgeMethod using = (options.algorithm - 1) % 6;
+
+		for (i = 0; i < b->count; i++) {
+			Vector P = vec(b->x[i], b->y[i], b->z[i]);
+			if (four_edges) {
+				b->valid[i] = interpolation_using_4_edges(c, P, using, &b->u[i], &b->v[i]);
+			} else {
+				b->valid[i] = interpolation_using_2_edges(c, P, using, &b->u[i], &b->v[i]);
+			}
+			b->valid[i] = b->valid[i] && isfinite(b->u[i]) && isfinite(b->v[i]);
+		}
+	}
+
+	// Overflowed samples are never valid
+	for (i = 0; i < b->count; i++) {
+		b->valid[i] &= !(b->flags[i] & VECTOR_FLAG_OVERFLOW);
+	}
+}  // }}}
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Smoothing and prediction                              {{{
+
+static double apply_smoothing(SmoothingVars *s, double value) {  // {{{
+	// Brown's double exponential smoothing, the same as mouseemu.c
+	// http://en.wikipedia.org/wiki/Exponential_smoothing
+	//
+	// The firmware clamps the second value between 0.0 and 1.0, and that
+	// is done here as well. Then, the trend is used to forecast the value
+	// a few samples in the future, which compensates for the delay
+	// introduced by the filter.
+
+	double alpha = options.alpha;
+	double level, trend;
+
+	if (alpha <= 0.0 || alpha >= 1.0) {
+		// Smoothing disabled
+		return value;
+	}
+
+	s->first  = s->first  * (1 - alpha) + value    * alpha;
+	s->second = s->second * (1 - alpha) + s->first * alpha;
+
+	if      (s->second < 0.0)  s->second = 0.0;
+	else if (s->second > 1.0)  s->second = 1.0;
+
+	if (options.predict <= 0.0) {
+		return s->second;
+	}
+
+	level = 2 * s->first - s->second;
+	trend = alpha / (1 - alpha) * (s->first - s->second);
+	return level + trend * options.predict;
+}  // }}}
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Output                                                {{{
+
+static int uinput_open(void) {  // {{{
+	struct uinput_user_dev dev;
+	int fd;
+	int i;
+
+	fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+	if (fd < 0) {
+		perror("open /dev/uinput");
+		return -1;
+	}
+
+	ioctl(fd, UI_SET_EVBIT, EV_SYN);
+	ioctl(fd, UI_SET_EVBIT, EV_KEY);
+	ioctl(fd, UI_SET_EVBIT, EV_ABS);
+	for (i = 0; i < 3; i++) {
+		ioctl(fd, UI_SET_KEYBIT, BTN_LEFT + i);
+	}
+	ioctl(fd, UI_SET_ABSBIT, ABS_X);
+	ioctl(fd, UI_SET_ABSBIT, ABS_Y);
+
+	memset(&dev, 0, sizeof(dev));
+	snprintf(dev.name, UINPUT_MAX_NAME_SIZE, "ATmega8 Magnetometer USB Mouse (host projection)");
+	dev.id.bustype = BUS_VIRTUAL;
+	// Same VID/PID as the firmware (see firmware/usbconfig.h)
+	dev.id.vendor  = 0x16c0;
+	dev.id.product = 0x27d9;
+	dev.id.version = 1;
+	dev.absmin[ABS_X] = 0;
+	dev.absmax[ABS_X] = ABS_RANGE;
+	dev.absmin[ABS_Y] = 0;
+	dev.absmax[ABS_Y] = ABS_RANGE;
+
+	if (write(fd, &dev, sizeof(dev)) != sizeof(dev) || ioctl(fd, UI_DEV_CREATE) < 0) {
+		perror("uinput device creation");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}  // }}}
+
+static void uinput_emit(int type, int code, int value) {  // {{{
+	struct input_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.type = type;
+	ev.code = code;
+	ev.value = value;
+	if (write(uinput_fd, &ev, sizeof(ev)) != sizeof(ev)) {
+		if (options.verbose) {
+			perror("uinput write");
+		}
+	}
+}  // }}}
+
+static void output_batch(Batch *b) {  // {{{
+	int i;
+
+	for (i = 0; i < b->count; i++) {
+		unsigned char buttons = b->flags[i] & VECTOR_FLAG_BUTTONS;
+		unsigned char pressed = buttons & ~state.buttons;
+		int moved = 0;
+
+		// Don't move the pointer for a short while after a click, the same
+		// way as the firmware does.
+		if (pressed) {
+			state.frozen_until = b->t[i] + options.freeze;
+		}
+
+		if (b->valid[i] && b->t[i] >= state.frozen_until) {
+			double x, y;
+
+			if (!state.smooth_initialized) {
+				state.smooth[0].first = state.smooth[0].second = b->u[i];
+				state.smooth[1].first = state.smooth[1].second = b->v[i];
+				state.smooth_initialized = 1;
+			}
+			x = apply_smoothing(&state.smooth[0], b->u[i]);
+			y = apply_smoothing(&state.smooth[1], b->v[i]);
+
+			if (options.print) {
+				printf("%f %f\n", x, y);
+			}
+
+			if      (x < 0.0)  x = 0.0;
+			else if (x > 1.0)  x = 1.0;
+			if      (y < 0.0)  y = 0.0;
+			else if (y > 1.0)  y = 1.0;
+
+			state.abs_x = (int) lround(x * ABS_RANGE);
+			state.abs_y = (int) lround(y * ABS_RANGE);
+			moved = 1;
+		} else {
+			state.discarded++;
+			if (options.print) {
+				puts("discarded");
+			}
+		}
+
+		if (uinput_fd >= 0) {
+			if (moved) {
+				uinput_emit(EV_ABS, ABS_X, state.abs_x);
+				uinput_emit(EV_ABS, ABS_Y, state.abs_y);
+			}
+			if (buttons != state.buttons) {
+				int j;
+				for (j = 0; j < 3; j++) {
+					if ((buttons ^ state.buttons) & (1 << j)) {
+						uinput_emit(EV_KEY, BTN_LEFT + j, !!(buttons & (1 << j)));
+					}
+				}
+			}
+			uinput_emit(EV_SYN, SYN_REPORT, 0);
+		}
+
+		state.buttons = buttons;
+	}
+
+	if (options.print) {
+		fflush(stdout);
+	}
+}  // }}}
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Input                                                 {{{
+
+static double now(void) {  // {{{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}  // }}}
+
+static void flush_batch(void) {  // {{{
+	if (batch.count == 0) {
+		return;
+	}
+	project_batch(&batch);
+	output_batch(&batch);
+	batch.count = 0;
+}  // }}}
+
+static void handle_report(const unsigned char *buf, int len, double timestamp) {  // {{{
+	// Appends one HID report to the current batch.
+	// Reports other than the vector report (keyboard, mouse) are ignored.
+
+	int i;
+
+	if (len != VECTOR_REPORT_SIZE || buf[0] != VECTOR_REPORT_ID) {
+		return;
+	}
+
+	state.reports++;
+
+	i = batch.count;
+	// Little-endian 16-bit signed integers
+	batch.x[i] = (short) (buf[1] | (buf[2] << 8));
+	batch.y[i] = (short) (buf[3] | (buf[4] << 8));
+	batch.z[i] = (short) (buf[5] | (buf[6] << 8));
+	batch.flags[i] = buf[7];
+	batch.t[i] = timestamp;
+
+	if (buf[7] & VECTOR_FLAG_OVERFLOW) {
+		state.overflows++;
+	}
+
+	batch.count++;
+	if (batch.count == BATCH_SIZE) {
+		flush_batch();
+	}
+}  // }}}
+
+static int load_calibration(FILE *f, int sample_mode) {  // {{{
+	// Reads a text stream in the same format as convert_coordinates.py and
+	// linear_eq_conversion.c: a corner name in one line, followed by the
+	// vector in the next line. This is exactly what the firmware prints at
+	// the "Print corners" menu item.
+	//
+	// If sample_mode is non-zero, any other vector is treated as a sample
+	// from the sensor, and is fed to handle_report(). A fourth number on
+	// the same line, if present, is used as the button state.
+	//
+	// Returns the number of corners read.
+
+	char line[256];
+	int corners_read = 0;
+	int next_corner = -1;
+	unsigned long sample_number = 0;
+	double start = now();
+
+	while (!should_quit && fgets(line, sizeof(line), f)) {
+		char name[64];
+		Vector v;
+		int buttons = 0;
+		int fields;
+		int i;
+
+		if (line[0] == '#') {
+			continue;
+		}
+
+		fields = sscanf(line, "%lf%lf%lf%d", &v.x, &v.y, &v.z, &buttons);
+		if (fields >= 3) {
+			if (next_corner >= 0) {
+				state.corners[next_corner] = v;
+				next_corner = -1;
+				corners_read++;
+			} else if (sample_mode) {
+				unsigned char report[VECTOR_REPORT_SIZE];
+				short sx = (short) v.x;
+				short sy = (short) v.y;
+				short sz = (short) v.z;
+				double timestamp;
+
+				// Simulating the device: building the same report as the
+				// firmware.
+				report[0] = VECTOR_REPORT_ID;
+				report[1] = sx & 0xFF;
+				report[2] = (sx >> 8) & 0xFF;
+				report[3] = sy & 0xFF;
+				report[4] = (sy >> 8) & 0xFF;
+				report[5] = sz & 0xFF;
+				report[6] = (sz >> 8) & 0xFF;
+				report[7] = buttons & VECTOR_FLAG_BUTTONS;
+				if (sx == -4096 || sy == -4096 || sz == -4096) {
+					report[7] |= VECTOR_FLAG_OVERFLOW;
+				}
+
+				if (options.replay_rate > 0) {
+					// Real-time replay: one report at a time
+					double when = start + sample_number / options.replay_rate;
+					double delay = when - now();
+					if (delay > 0) {
+						usleep((useconds_t) (delay * 1e6));
+					}
+					timestamp = when;
+					handle_report(report, sizeof(report), timestamp);
+					flush_batch();
+				} else {
+					// As fast as possible, in full batches
+					timestamp = sample_number / 75.0;
+					handle_report(report, sizeof(report), timestamp);
+				}
+				sample_number++;
+			}
+		} else if (sscanf(line, " %63s", name) == 1) {
+			for (i = 0; i < TOTAL_CORNERS; i++) {
+				if (strcmp(name, corner_names[i]) == 0) {
+					next_corner = i;
+				}
+			}
+		}
+	}
+
+	flush_batch();
+	return corners_read;
+}  // }}}
+
+static int run_hidraw(const char *path) {  // {{{
+	struct pollfd pfd;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_NONBLOCK);
+	if (fd < 0) {
+		perror(path);
+		return 1;
+	}
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+
+	while (!should_quit) {
+		int ret = poll(&pfd, 1, 1000);
+		if (ret < 0) {
+			if (errno == EINTR) continue;
+			perror("poll");
+			break;
+		}
+		if (ret == 0) {
+			continue;
+		}
+
+		// Draining all pending reports into one batch. Each read()
+		// returns exactly one report (including the report ID).
+		for (;;) {
+			unsigned char buf[64];
+			int len = read(fd, buf, sizeof(buf));
+			if (len < 0) {
+				if (errno != EAGAIN && errno != EINTR) {
+					perror("read");
+					should_quit = 1;
+				}
+				break;
+			}
+			handle_report(buf, len, now());
+		}
+		flush_batch();
+	}
+
+	close(fd);
+	return 0;
+}  // }}}
+
+// }}}
+
+
+////////////////////////////////////////////////////////////
+// Main                                                  {{{
+
+static void usage(const char *prog) {  // {{{
+	printf(
+		"Usage: %s [options]\n"
+		"\n"
+		"Reads X,Y,Z vectors from the device (firmware built with\n"
+		"ENABLE_HOST_PROJECTION=1) and moves the pointer through uinput.\n"
+		"\n"
+		"Input (one of these is required):\n"
+		"  -d, --device PATH       hidraw device node, such as /dev/hidraw3\n"
+		"  -r, --replay FILE       simulates the device by replaying a recorded log\n"
+		"                          (\"-\" means stdin); the log may also contain the\n"
+		"                          calibration corners\n"
+		"  -R, --rate HZ           replay rate; 0 means as fast as possible (%g)\n"
+		"\n"
+		"Processing:\n"
+		"  -c, --calibration FILE  file with the 4 corners, such as the output of\n"
+		"                          the \"Print corners\" menu item\n"
+		"  -a, --algorithm N       3D->2D algorithm, 1..13 are the same as\n"
+		"                          convert_coordinates.py, 0 is the same as the\n"
+		"                          firmware (%d)\n"
+		"  -s, --smoothing ALPHA   smoothing factor, 0 disables it (%g)\n"
+		"  -p, --predict N         forecast N samples ahead to compensate for\n"
+		"                          the smoothing delay (%g)\n"
+		"  -f, --freeze SECONDS    ignore movement for a while after a click (%g)\n"
+		"\n"
+		"Output:\n"
+		"  -u, --uinput            moves the pointer (default with --device)\n"
+		"  -o, --print             prints the coordinates (default with --replay)\n"
+		"  -v, --verbose           prints statistics at exit\n",
+		prog,
+		options.replay_rate,
+		options.algorithm,
+		options.alpha,
+		options.predict,
+		options.freeze
+	);
+}  // }}}
+
+static void on_signal(int sig) {  // {{{
+	(void) sig;
+	should_quit = 1;
+}  // }}}
+
+int main(int argc, char *argv[]) {  // {{{
+	static const struct option long_options[] = {
+		{"device",      required_argument, NULL, 'd'},
+		{"replay",      required_argument, NULL, 'r'},
+		{"rate",        required_argument, NULL, 'R'},
+		{"calibration", required_argument, NULL, 'c'},
+		{"algorithm",   required_argument, NULL, 'a'},
+		{"smoothing",   required_argument, NULL, 's'},
+		{"predict",     required_argument, NULL, 'p'},
+		{"freeze",      required_argument, NULL, 'f'},
+		{"uinput",      no_argument,       NULL, 'u'},
+		{"print",       no_argument,       NULL, 'o'},
+		{"verbose",     no_argument,       NULL, 'v'},
+		{"help",        no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	int opt;
+	int ret = 0;
+
+	// Defaults, matching the firmware behavior
+	options.replay_rate = 0;
+	options.algorithm = 0;
+	options.alpha = 0.125;
+	options.predict = 0;
+	// 64 * 1.365ms, from buttons.c
+	options.freeze = 0.08736;
+
+	while ((opt = getopt_long(argc, argv, "d:r:R:c:a:s:p:f:uovh", long_options, NULL)) != -1) {
+		switch (opt) {
+			case 'd': options.device = optarg; break;
+			case 'r': options.replay = optarg; break;
+			case 'R': options.replay_rate = atof(optarg); break;
+			case 'c': options.calibration = optarg; break;
+			case 'a': options.algorithm = atoi(optarg); break;
+			case 's': options.alpha = atof(optarg); break;
+			case 'p': options.predict = atof(optarg); break;
+			case 'f': options.freeze = atof(optarg); break;
+			case 'u': options.use_uinput = 1; break;
+			case 'o': options.print = 1; break;
+			case 'v': options.verbose = 1; break;
+			case 'h': usage(argv[0]); return 0;
+			default:  usage(argv[0]); return 2;
+		}
+	}
+
+	if ((options.device == NULL) == (options.replay == NULL)) {
+		fprintf(stderr, "Exactly one of --device or --replay is required.\n");
+		return 2;
+	}
+	if (options.algorithm < MIN_ALGORITHM || options.algorithm > MAX_ALGORITHM) {
+		fprintf(stderr, "Invalid algorithm: %d\n", options.algorithm);
+		return 2;
+	}
+	if (!options.use_uinput && !options.print) {
+		if (options.device) {
+			options.use_uinput = 1;
+		} else {
+			options.print = 1;
+		}
+	}
+
+	if (options.calibration) {
+		FILE *f = fopen(options.calibration, "r");
+		if (!f) {
+			perror(options.calibration);
+			return 1;
+		}
+		if (load_calibration(f, 0) != TOTAL_CORNERS) {
+			fprintf(stderr, "Warning: not all corners were found at %s\n", options.calibration);
+		}
+		fclose(f);
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	if (options.use_uinput) {
+		uinput_fd = uinput_open();
+		if (uinput_fd < 0) {
+			return 1;
+		}
+	}
+
+	if (options.device) {
+		ret = run_hidraw(options.device);
+	} else {
+		FILE *f = strcmp(options.replay, "-") == 0 ? stdin : fopen(options.replay, "r");
+		if (!f) {
+			perror(options.replay);
+			ret = 1;
+		} else {
+			load_calibration(f, 1);
+			if (f != stdin) fclose(f);
+		}
+	}
+
+	if (uinput_fd >= 0) {
+		ioctl(uinput_fd, UI_DEV_DESTROY);
+		close(uinput_fd);
+	}
+
+	if (options.verbose) {
+		fprintf(stderr, "reports=%lu discarded=%lu overflows=%lu\n",
+			state.reports, state.discarded, state.overflows);
+	}
+
+	return ret;
+}  // }}}
+
+// }}}
+
+// vim:noexpandtab tabstop=4 shiftwidth=4 foldmethod=marker foldmarker={{{,}}}
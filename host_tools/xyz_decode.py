@@ -0,0 +1,138 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Decodes the text typed by "Print X,Y,Z compact" (firmware built with
+# ENABLE_COMPACT_XYZ = 1), after capturing it in any text editor:
+#   ./xyz_decode.py capture.txt -o samples.bin
+#   ./xyz_decode.py --text capture.txt
+#
+# Each line is 10 base-32 digits holding, most significant bits first:
+#   x (13 bits), y (13 bits), z (13 bits), seq (3 bits), crc (8 bits)
+# See XYZVector_to_compact() at firmware/keyemu.c.
+#
+# The binary output has one little-endian '<hhh' record per valid line.
+# Lines with a bad CRC are skipped, and jumps in the 3-bit line counter are
+# reported as lost lines (more than 7 lost lines in a row go unnoticed).
+
+from __future__ import print_function
+
+import argparse
+import struct
+import sys
+
+
+# Crockford's base-32, lowercase. Uppercase and the ambiguous letters are
+# also accepted, in case the capture went through some other tool.
+ALPHABET = '0123456789abcdefghjkmnpqrstvwxyz'
+DIGITS = dict((c, i) for i, c in enumerate(ALPHABET))
+DIGITS.update({'i': 1, 'l': 1, 'o': 0})
+
+LINE_LENGTH = 10
+RECORD_FORMAT = '<hhh'
+
+
+def crc8(data):
+    # Polynomial 0x07, initial value 0, MSB first, same as crc8_update()
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for i in range(8):
+            if crc & 0x80:
+                crc = ((crc << 1) ^ 0x07) & 0xFF
+            else:
+                crc = (crc << 1) & 0xFF
+    return crc
+
+
+def sign_extend_13(value):
+    if value & 0x1000:
+        return value - 0x2000
+    return value
+
+
+def decode_line(line):
+    # Returns (x, y, z, seq), or None if the line is not valid.
+    line = line.strip().lower()
+    if len(line) != LINE_LENGTH:
+        return None
+
+    bits = 0
+    for c in line:
+        if c not in DIGITS:
+            return None
+        bits = (bits << 5) | DIGITS[c]
+
+    crc = bits & 0xFF
+    seq = (bits >> 8) & 0x07
+    z = (bits >> 11) & 0x1FFF
+    y = (bits >> 24) & 0x1FFF
+    x = (bits >> 37) & 0x1FFF
+
+    data = bytearray([
+        x & 0xFF, x >> 8,
+        y & 0xFF, y >> 8,
+        z & 0xFF, z >> 8,
+        seq,
+    ])
+    if crc8(data) != crc:
+        return None
+
+    return sign_extend_13(x), sign_extend_13(y), sign_extend_13(z), seq
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Decodes the compact X,Y,Z lines typed by the firmware'
+    )
+    parser.add_argument(
+        'input', nargs='?', type=argparse.FileType('r'), default=sys.stdin,
+        help='Captured text (default: stdin)'
+    )
+    parser.add_argument(
+        '-o', '--output', type=argparse.FileType('wb'),
+        help='Binary output, one <hhh record per sample'
+    )
+    parser.add_argument(
+        '-t', '--text', action='store_true',
+        help='Prints the samples as "x\\ty\\tz", like the decimal output'
+    )
+    options = parser.parse_args()
+
+    valid = 0
+    invalid = 0
+    lost = 0
+    last_seq = None
+
+    for line in options.input:
+        if not line.strip():
+            continue
+
+        sample = decode_line(line)
+        if sample is None:
+            invalid += 1
+            # The counter cannot be trusted across a bad line
+            last_seq = None
+            continue
+
+        x, y, z, seq = sample
+        if last_seq is not None:
+            lost += (seq - last_seq - 1) & 0x07
+        last_seq = seq
+        valid += 1
+
+        if options.output:
+            options.output.write(struct.pack(RECORD_FORMAT, x, y, z))
+        if options.text:
+            print('{0}\t{1}\t{2}'.format(x, y, z))
+
+    print(
+        '{0} valid lines, {1} invalid lines, {2} lost lines'.format(valid, invalid, lost),
+        file=sys.stderr
+    )
+
+    return 0 if invalid == 0 else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
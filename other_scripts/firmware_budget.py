@@ -0,0 +1,423 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# vi:ts=4 sw=4 et
+
+# Builds the firmware at every commit of the git history, for several
+# configurations, and keeps the size of every symbol in a SQLite database.
+# Replaces grab_firmware_size_data.sh, which walked the old Mercurial
+# history (its results are still at size_vs_commit.txt).
+#
+# Usage:
+#   ./firmware_budget.py update [-j 8] [REVISIONS]
+#   ./firmware_budget.py show [COMMIT [OLD_COMMIT]]
+#   ./firmware_size_graph.py
+#
+# "update" builds, in parallel, every (commit, configuration) pair that is
+# not yet in the database, so running it again after new commits only
+# builds the new ones. Failed builds are also stored (with no sizes), and
+# are only tried again with --retry-failed. REVISIONS is anything accepted
+# by "git rev-list" (default: HEAD), and only the first-parent history is
+# walked.
+#
+# Each build happens in a temporary directory, extracted with "git archive",
+# so the working copy is never touched and there is no need for a separate
+# clone. avr-gcc, avr-nm and avr-size must be in the PATH.
+#
+# "show" prints the ROM/RAM of each configuration of a commit (default:
+# the newest one in the database), and the symbols that have changed since
+# another commit (default: the previous one).
+#
+# CPU cycles are not measured by this script, since the firmware only runs
+# with a USB host and a sensor attached. Instead, --cycles-cmd runs an
+# external command for each built ELF file, as "CMD config path/to/main.elf",
+# and stores its output, which must be one "function<TAB>cycles" line per
+# measured function (e.g. from a simulator running a test harness). On real
+# hardware, use ENABLE_PROFILING and host_tools/profile_dump.py instead.
+
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import multiprocessing
+import os
+import os.path
+import shutil
+import sqlite3
+import subprocess
+import sys
+import tempfile
+
+
+# Path relative to this script
+DEFAULT_DATABASE = 'firmware_budget.sqlite'
+
+# Directory of the firmware inside the repository
+FIRMWARE_DIR = 'firmware'
+
+# Configuration name -> make target and variables
+# These are the combinations from the size table at the Makefile.
+CONFIGS = [
+    ('keyboard',                'all',  {'ENABLE_MOUSE': 0, 'ENABLE_KEYBOARD': 1, 'ENABLE_FULL_MENU': 0}),
+    ('keyboard-fullmenu',       'all',  {'ENABLE_MOUSE': 0, 'ENABLE_KEYBOARD': 1, 'ENABLE_FULL_MENU': 1}),
+    ('mouse',                   'all',  {'ENABLE_MOUSE': 1, 'ENABLE_KEYBOARD': 0, 'ENABLE_FULL_MENU': 0}),
+    ('mouse-keyboard',          'all',  {'ENABLE_MOUSE': 1, 'ENABLE_KEYBOARD': 1, 'ENABLE_FULL_MENU': 0}),
+    ('mouse-keyboard-fullmenu', 'all',  {'ENABLE_MOUSE': 1, 'ENABLE_KEYBOARD': 1, 'ENABLE_FULL_MENU': 1}),
+    ('bootloader',              'boot', {}),
+]
+CONFIG_NAMES = [c[0] for c in CONFIGS]
+
+# Where each make target leaves its ELF file, relative to FIRMWARE_DIR
+ELF_FILES = {
+    'all': 'main.elf',
+    'boot': 'bootloader/bootloader.elf',
+}
+
+# Symbol types from avr-nm that are stored
+FLASH_TYPES = 'tTrR'
+RAM_TYPES = 'bBdD'
+
+SCHEMA = '''
+CREATE TABLE IF NOT EXISTS commits (
+    hash TEXT PRIMARY KEY,
+    seq INTEGER,       -- Position in the first-parent history
+    date TEXT,
+    subject TEXT
+);
+CREATE TABLE IF NOT EXISTS builds (
+    id INTEGER PRIMARY KEY,
+    hash TEXT NOT NULL,
+    config TEXT NOT NULL,
+    ok INTEGER NOT NULL,
+    rom INTEGER,       -- .text + .data
+    ram INTEGER,       -- .data + .bss
+    eeprom INTEGER,
+    UNIQUE (hash, config)
+);
+-- Symbol names are stored only once
+CREATE TABLE IF NOT EXISTS names (
+    id INTEGER PRIMARY KEY,
+    name TEXT UNIQUE NOT NULL
+);
+CREATE TABLE IF NOT EXISTS symbols (
+    build INTEGER NOT NULL,
+    name INTEGER NOT NULL,
+    type TEXT NOT NULL,  -- From avr-nm
+    size INTEGER NOT NULL,
+    PRIMARY KEY (build, name, type)
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS cycles (
+    build INTEGER NOT NULL,
+    name INTEGER NOT NULL,
+    cycles INTEGER NOT NULL,
+    PRIMARY KEY (build, name)
+) WITHOUT ROWID;
+'''
+
+
+def git(repo, *args):
+    return subprocess.check_output(('git', '-C', repo) + args).decode('utf-8')
+
+
+def open_database(path):
+    db = sqlite3.connect(path)
+    db.executescript(SCHEMA)
+    return db
+
+
+def list_commits(repo, revisions):
+    # Returns [(hash, date, subject)], oldest first
+    out = git(repo, 'log', '--first-parent', '--reverse', '--format=%H%x09%ci%x09%s', revisions)
+    return [tuple(line.split('\t', 2)) for line in out.splitlines() if line]
+
+
+########################################################################
+# Building (runs inside the worker processes)
+
+def read_sizes(elf):
+    # Same sums as the checksize script
+    out = subprocess.check_output(['avr-size', '--format=sysv', '--radix=10', elf]).decode('utf-8')
+    section = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith('.') and fields[1].isdigit():
+            section[fields[0]] = int(fields[1])
+    get = lambda name: section.get(name, 0)
+    return get('.text') + get('.data'), get('.data') + get('.bss'), get('.eeprom')
+
+
+def read_symbols(elf):
+    # Returns [(name, type, size)]
+    out = subprocess.check_output(['avr-nm', '-f', 'bsd', '-t', 'd', '-S', elf]).decode('utf-8')
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in FLASH_TYPES + RAM_TYPES:
+            symbols.append((fields[3], fields[2], int(fields[1], 10)))
+    return symbols
+
+
+def read_cycles(cycles_cmd, config, elf):
+    # Returns [(name, cycles)]
+    out = subprocess.check_output(cycles_cmd.split() + [config, elf]).decode('utf-8')
+    cycles = []
+    for line in out.splitlines():
+        fields = line.split('\t')
+        if len(fields) == 2 and fields[1].strip().isdigit():
+            cycles.append((fields[0].strip(), int(fields[1])))
+    return cycles
+
+
+def build(job):
+    # Returns (hash, config, result), result being None if the build failed,
+    # or a dict with the sizes, the symbols and the cycles.
+    repo, commit, config, cycles_cmd, verbose = job
+    target, variables = dict((c[0], (c[1], c[2])) for c in CONFIGS)[config]
+
+    tmpdir = tempfile.mkdtemp(prefix='firmware_budget_')
+    try:
+        archive = subprocess.Popen(
+            ['git', '-C', repo, 'archive', '--format=tar', commit, FIRMWARE_DIR],
+            stdout=subprocess.PIPE, stderr=open(os.devnull, 'w')
+        )
+        tar_status = subprocess.call(['tar', '-x', '-C', tmpdir], stdin=archive.stdout)
+        if archive.wait() != 0 or tar_status != 0:
+            # No firmware in this commit
+            return commit, config, None
+
+        firmware = os.path.join(tmpdir, FIRMWARE_DIR)
+        command = ['make', '-C', firmware, target]
+        command += ['{0}={1}'.format(k, v) for k, v in sorted(variables.items())]
+        output = None if verbose else open(os.devnull, 'w')
+        # make fails if checksize finds the firmware too big, but the ELF
+        # file is still there, and is still worth measuring.
+        subprocess.call(command, stdout=output, stderr=output)
+
+        elf = os.path.join(firmware, ELF_FILES[target])
+        if not os.path.exists(elf):
+            return commit, config, None
+
+        result = {}
+        result['rom'], result['ram'], result['eeprom'] = read_sizes(elf)
+        result['symbols'] = read_symbols(elf)
+        result['cycles'] = read_cycles(cycles_cmd, config, elf) if cycles_cmd else []
+        return commit, config, result
+    except (OSError, subprocess.CalledProcessError) as e:
+        print('{0} {1}: {2}'.format(commit[:12], config, e), file=sys.stderr)
+        return commit, config, None
+    finally:
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+
+########################################################################
+# Database
+
+def name_id(db, name):
+    db.execute('INSERT OR IGNORE INTO names (name) VALUES (?)', (name,))
+    return db.execute('SELECT id FROM names WHERE name = ?', (name,)).fetchone()[0]
+
+
+def store_build(db, commit, config, result):
+    db.execute('DELETE FROM builds WHERE hash = ? AND config = ?', (commit, config))
+    if result is None:
+        db.execute(
+            'INSERT INTO builds (hash, config, ok) VALUES (?, ?, 0)',
+            (commit, config)
+        )
+        return
+
+    build_id = db.execute(
+        'INSERT INTO builds (hash, config, ok, rom, ram, eeprom) VALUES (?, ?, 1, ?, ?, ?)',
+        (commit, config, result['rom'], result['ram'], result['eeprom'])
+    ).lastrowid
+    db.executemany(
+        'INSERT OR REPLACE INTO symbols (build, name, type, size) VALUES (?, ?, ?, ?)',
+        [(build_id, name_id(db, name), type, size) for name, type, size in result['symbols']]
+    )
+    db.executemany(
+        'INSERT OR REPLACE INTO cycles (build, name, cycles) VALUES (?, ?, ?)',
+        [(build_id, name_id(db, name), cycles) for name, cycles in result['cycles']]
+    )
+
+
+def cleanup_orphans(db):
+    # Symbols of builds that have been replaced (--retry-failed)
+    db.execute('DELETE FROM symbols WHERE build NOT IN (SELECT id FROM builds)')
+    db.execute('DELETE FROM cycles WHERE build NOT IN (SELECT id FROM builds)')
+
+
+########################################################################
+# Commands
+
+def cmd_update(options, db):
+    commits = list_commits(options.repo, options.revisions)
+    # Also renumbers the commits, in case the history has been rewritten
+    db.executemany(
+        'INSERT OR REPLACE INTO commits (hash, seq, date, subject) VALUES (?, ?, ?, ?)',
+        [(h, seq, date, subject) for seq, (h, date, subject) in enumerate(commits, 1)]
+    )
+    db.commit()
+
+    done = set(db.execute(
+        'SELECT hash, config FROM builds' + (' WHERE ok = 1' if options.retry_failed else '')
+    ))
+    jobs = [
+        (options.repo, h, config, options.cycles_cmd, options.verbose)
+        for h, date, subject in commits
+        for config in options.configs
+        if (h, config) not in done
+    ]
+    if not jobs:
+        print('Nothing to build.')
+        return 0
+
+    print('Building {0} configurations of {1} commits, {2} at a time.'.format(
+        len(jobs), len(set(j[1] for j in jobs)), options.jobs
+    ))
+    pool = multiprocessing.Pool(options.jobs)
+    try:
+        for count, (commit, config, result) in enumerate(pool.imap_unordered(build, jobs), 1):
+            # Stored as soon as possible, so that an interrupted update is
+            # not lost.
+            store_build(db, commit, config, result)
+            db.commit()
+            print('[{0}/{1}] {2} {3:<24} {4}'.format(
+                count, len(jobs), commit[:12], config,
+                'ROM {rom} RAM {ram}'.format(**result) if result else 'failed'
+            ))
+        pool.close()
+    finally:
+        pool.terminate()
+        pool.join()
+        cleanup_orphans(db)
+        db.commit()
+    return 0
+
+
+def find_commit(db, prefix, before=None):
+    # Returns (hash, seq, subject) of the given commit, or of the newest one
+    # with successful builds (before "before", if given).
+    query = 'SELECT c.hash, c.seq, c.subject FROM commits c WHERE '
+    if prefix:
+        row = db.execute(query + 'c.hash LIKE ? ORDER BY c.seq DESC', (prefix + '%',)).fetchone()
+    else:
+        row = db.execute(
+            query + 'EXISTS (SELECT 1 FROM builds b WHERE b.hash = c.hash AND b.ok = 1)'
+            ' AND c.seq < ? ORDER BY c.seq DESC',
+            (before if before is not None else 1 << 62,)
+        ).fetchone()
+    return row
+
+
+def load_symbols(db, commit, config):
+    return dict(
+        ((name, type), size) for name, type, size in db.execute(
+            'SELECT n.name, s.type, s.size FROM symbols s'
+            ' JOIN builds b ON b.id = s.build JOIN names n ON n.id = s.name'
+            ' WHERE b.hash = ? AND b.config = ?', (commit, config)
+        )
+    )
+
+
+def resolve(repo, revision):
+    # Accepts anything git accepts (HEAD~2, branch names...)
+    if not revision:
+        return None
+    try:
+        return git(repo, 'rev-parse', '--verify', '-q', revision + '^{commit}').strip()
+    except subprocess.CalledProcessError:
+        return revision
+
+
+def cmd_show(options, db):
+    options.commit = resolve(options.repo, options.commit)
+    options.old_commit = resolve(options.repo, options.old_commit)
+    new = find_commit(db, options.commit)
+    if new is None:
+        print('Commit not found in the database.', file=sys.stderr)
+        return 1
+    old = find_commit(db, options.old_commit, None if options.old_commit else new[1])
+
+    print('{0} {1}'.format(new[0][:12], new[2]))
+    if old:
+        print('compared to {0} {1}'.format(old[0][:12], old[2]))
+    print()
+
+    for config in options.configs:
+        row = db.execute(
+            'SELECT ok, rom, ram FROM builds WHERE hash = ? AND config = ?', (new[0], config)
+        ).fetchone()
+        if row is None:
+            continue
+        if not row[0]:
+            print('{0:<24} build failed'.format(config))
+            continue
+        print('{0:<24} ROM {1:5d}  RAM {2:4d}'.format(config, row[1], row[2]))
+
+        if not old:
+            continue
+        new_symbols = load_symbols(db, new[0], config)
+        old_symbols = load_symbols(db, old[0], config)
+        for key in sorted(set(new_symbols) | set(old_symbols)):
+            before = old_symbols.get(key, 0)
+            after = new_symbols.get(key, 0)
+            if before != after:
+                print('    {0:+6d} {1:5d} {2} {3}'.format(after - before, after, key[1], key[0]))
+
+        for name, cycles in db.execute(
+            'SELECT n.name, c.cycles FROM cycles c'
+            ' JOIN builds b ON b.id = c.build JOIN names n ON n.id = c.name'
+            ' WHERE b.hash = ? AND b.config = ? ORDER BY n.name', (new[0], config)
+        ):
+            print('    {0:8d} cycles {1}'.format(cycles, name))
+    return 0
+
+
+def main():
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+
+    parser = argparse.ArgumentParser(
+        description='Tracks the size of the firmware symbols across the git history'
+    )
+    parser.add_argument(
+        '--db', default=os.path.join(script_dir, DEFAULT_DATABASE),
+        help='SQLite database (default: %(default)s)'
+    )
+    parser.add_argument(
+        '--repo', default=os.path.join(script_dir, '..'),
+        help='git repository (default: the one holding this script)'
+    )
+    parser.add_argument(
+        '-c', '--config', dest='configs', action='append', choices=CONFIG_NAMES,
+        help='Only this configuration (may be repeated, default: all of them)'
+    )
+    subparsers = parser.add_subparsers(dest='command')
+
+    update = subparsers.add_parser('update', help='Builds the new commits')
+    update.add_argument('revisions', nargs='?', default='HEAD')
+    update.add_argument(
+        '-j', '--jobs', type=int, default=multiprocessing.cpu_count(),
+        help='Parallel builds (default: %(default)s)'
+    )
+    update.add_argument('--retry-failed', action='store_true')
+    update.add_argument('--cycles-cmd', help='Command that measures the CPU cycles (see above)')
+    update.add_argument('-v', '--verbose', action='store_true', help='Shows the output of make')
+
+    show = subparsers.add_parser('show', help='Prints the sizes of a commit')
+    show.add_argument('commit', nargs='?')
+    show.add_argument('old_commit', nargs='?')
+
+    options = parser.parse_args()
+    if not options.configs:
+        options.configs = CONFIG_NAMES
+
+    db = open_database(options.db)
+    if options.command == 'update':
+        return cmd_update(options, db)
+    elif options.command == 'show':
+        return cmd_show(options, db)
+    parser.print_help()
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
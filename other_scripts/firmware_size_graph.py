@@ -2,40 +2,54 @@
 # -*- coding: utf-8 -*-
 # vi:ts=4 sw=4 et
 
+# Plots the firmware size along the git history, from the database built by
+# firmware_budget.py:
+#   ./firmware_size_graph.py
+#   ./firmware_size_graph.py --ram
+#   ./firmware_size_graph.py --symbol mouse_axes_linear_equation_system
+
 from __future__ import division
 from __future__ import print_function
 
-from itertools import izip
+import argparse
+import os.path
+import sqlite3
+
 import matplotlib.pyplot as pyplot
 
+from firmware_budget import CONFIG_NAMES, DEFAULT_DATABASE
+
 
 class Row(object):
-    def __init__(self, rev, node, size1, size2, date, desc):
-        self.rev = int(rev)
+    def __init__(self, seq, node, config, size):
+        self.seq = int(seq)
         self.node = node
-        self.size1 = int(size1)
-        self.size2 = int(size2)
-        # Might be a great idea to convert this to a datetime object
-        self.date = date
-        self.desc = desc
+        self.config = config
+        self.size = int(size)
 
     def __repr__(self):
-        return 'Row({rev}, {node}, {size1}, {size2}, {date}, {desc})'.format(**self.__dict__)
-
-def load_data(f):
-    data = []
-
-    for line in f:
-        line = line.strip()
-        # Ignoring comments and empty lines
-        if line.startswith('#') or line == '':
-            continue
-
-        fields=line.split('\t', 5)
-        row = Row(*fields)
-        data.append(row)
-
-    return data
+        return 'Row({seq}, {node}, {config}, {size})'.format(**self.__dict__)
+
+def load_data(db, column, symbol):
+    if symbol:
+        query = (
+            'SELECT c.seq, c.hash, b.config, SUM(s.size) FROM builds b'
+            ' JOIN commits c ON c.hash = b.hash'
+            ' JOIN symbols s ON s.build = b.id'
+            ' JOIN names n ON n.id = s.name'
+            ' WHERE b.ok = 1 AND n.name = ?'
+            ' GROUP BY b.id ORDER BY c.seq'
+        )
+        args = (symbol,)
+    else:
+        query = (
+            'SELECT c.seq, c.hash, b.config, b.{0} FROM builds b'
+            ' JOIN commits c ON c.hash = b.hash'
+            ' WHERE b.ok = 1 ORDER BY c.seq'
+        ).format(column)
+        args = ()
+
+    return [Row(*fields) for fields in db.execute(query, args)]
 
 def show_legend():
     l = pyplot.legend(loc='upper left', fancybox=True, shadow=True)
@@ -47,55 +61,70 @@ def show_legend():
     for t in l.get_texts():
         t.set_fontsize('x-small')
 
-def plot_but_skip_zeros(revs, sizes, *args, **kwargs):
-    data = [
-        x for x in izip(revs, sizes)
-        if x[1] > 0
-    ]
+def plot_config(data, config, *args, **kwargs):
+    # Failed builds are not in the data, and leave a gap in the line
+    rows = [row for row in data if row.config == config]
+    if not rows:
+        return
     pyplot.plot(
-        [x[0] for x in data],
-        [x[1] for x in data],
-        *args, **kwargs
+        [row.seq for row in rows],
+        [row.size for row in rows],
+        *args, label=config, **kwargs
     )
 
 def main():
-    with open('size_vs_commit.txt', 'r') as f:
-        data = load_data(f)
+    script_dir = os.path.dirname(os.path.abspath(__file__))
 
-    max_rev = max(row.rev for row in data)
+    parser = argparse.ArgumentParser(
+        description='Plots the firmware size along the git history'
+    )
+    parser.add_argument(
+        '--db', default=os.path.join(script_dir, DEFAULT_DATABASE),
+        help='Database from firmware_budget.py (default: %(default)s)'
+    )
+    group = parser.add_mutually_exclusive_group()
+    group.add_argument('--ram', action='store_true', help='Plots the RAM instead of the ROM')
+    group.add_argument('--symbol', help='Plots the size of a single function or variable')
+    options = parser.parse_args()
+
+    db = sqlite3.connect(options.db)
+    data = load_data(db, 'ram' if options.ram else 'rom', options.symbol)
+    if not data:
+        print('No data, run "./firmware_budget.py update" first.')
+        return
+
+    max_seq = max(row.seq for row in data)
     flash_size = 8*1024
+    ram_size = 1024
     bootloader_limit = 6*1024
 
-    plot_but_skip_zeros(
-        (row.rev for row in data),
-        (row.size1 for row in data),
-        label='make all'
-    )
-    plot_but_skip_zeros(
-        (row.rev for row in data),
-        (row.size2 for row in data),
-        label='make combine'
-    )
+    for config in CONFIG_NAMES:
+        plot_config(data, config, marker='.')
 
     pyplot.grid(True)
     show_legend()
 
-    pyplot.xlim(0, max_rev)
-    pyplot.xticks(range(0, max_rev+1, 25))
-    pyplot.xlabel('Revision number')
-
-    pyplot.ylim(0, flash_size)
-    pyplot.yticks(range(0, flash_size+1, 512))
+    pyplot.xlim(0, max_seq)
+    pyplot.xlabel('Commit number (first-parent history)')
     pyplot.ylabel('Size (bytes)')
 
-    # Bootloader limit
-    pyplot.axhline(y=bootloader_limit, color='r')
-    pyplot.annotate(
-        u'Bootloader', xy=(0, bootloader_limit),
-        xytext=(5, 5), textcoords='offset points',
-        ha='left', va='bottom',
-        color='r'
-    )
+    if options.symbol:
+        pyplot.title(options.symbol)
+    elif options.ram:
+        pyplot.ylim(0, ram_size)
+        pyplot.yticks(range(0, ram_size+1, 64))
+    else:
+        pyplot.ylim(0, flash_size)
+        pyplot.yticks(range(0, flash_size+1, 512))
+
+        # Bootloader limit
+        pyplot.axhline(y=bootloader_limit, color='r')
+        pyplot.annotate(
+            u'Bootloader', xy=(0, bootloader_limit),
+            xytext=(5, 5), textcoords='offset points',
+            ha='left', va='bottom',
+            color='r'
+        )
 
 
     pyplot.show()